@@ -0,0 +1,35 @@
+#include "runtime.h"
+
+#define RUNTIME_EXPORT(symbol, function) .set numImports, numImports + 1
+	.set numImports, 0
+#include "runtime_exports.h"
+#undef RUNTIME_EXPORT
+
+@ Replaced with the address of the runtime's table by the loader
+	.data
+	.balign 4
+	.global runtimeImportSlot
+runtimeImportSlot:
+	.word RUNTIME_VERSION << 16 | numImports
+
+@ Each stub jumps to its entry of the table, which takes care of
+@ switching to Thumb. Only r12 is used, which calls may clobber.
+	.set importID, 0
+
+	.macro IMPORT symbol
+	.section .text.\symbol, "ax", %progbits
+	.arm
+	.balign 4
+	.global \symbol
+	.type \symbol, %function
+\symbol:
+	ldr r12, =runtimeImportSlot
+	ldr r12, [r12]
+	ldr pc, [r12, #4 + 4 * importID]
+	.ltorg
+	.set importID, importID + 1
+	.endm
+
+#define RUNTIME_EXPORT(symbol, function) IMPORT symbol
+#include "runtime_exports.h"
+#undef RUNTIME_EXPORT
@@ -0,0 +1,784 @@
+#include "analytic_colliders.h"
+#include "clsn_math.h"
+#include <algorithm>
+
+using namespace ClsnMath;
+
+template<class T>
+static constexpr SpawnInfo MakeSpawnInfo()
+{
+	return
+	{
+		+[]() -> ActorBase* { return new T; },
+		T::staticActorID, // behavPriority
+		T::staticActorID, // renderPriority
+		0,      // flags
+		0_f,    // rangeOffsetY
+		-1._f,  // range
+		0_f,    // drawDist
+		0_f     // unkc0
+	};
+}
+
+constinit SpawnInfo BoxCollider::spawnData      = MakeSpawnInfo<BoxCollider>();
+constinit SpawnInfo SlopeCollider::spawnData    = MakeSpawnInfo<SlopeCollider>();
+constinit SpawnInfo CylinderCollider::spawnData = MakeSpawnInfo<CylinderCollider>();
+constinit SpawnInfo SphereCollider::spawnData   = MakeSpawnInfo<SphereCollider>();
+constinit SpawnInfo MovingPlatform::spawnData   = MakeSpawnInfo<MovingPlatform>();
+
+// Surfaces with a steeper normal than this are walls
+constexpr Fix12i minFloorNormalY = 0.7_f;
+
+static bool IsSamePoint(const Vector3& a, const Vector3& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// Returns how far along the line the point where it enters a sphere or a vertical cylinder
+// is, or a negative value if there is none. rel is the start of the line relative to the
+// center. For cylinders, the y components of rel and v are zero.
+static Fix12i EnterRound(const Vector3& rel, const Vector3& v, Fix12i radius)
+{
+	const Fix12i length = RootOf(Sq(v.x) + Sq(v.y) + Sq(v.z));
+
+	if (length < 1._f) return -1._f;
+
+	const Vector3 dir = {v.x / length, v.y / length, v.z / length};
+
+	const Fix12i proj = rel.x * dir.x + rel.y * dir.y + rel.z * dir.z;
+	const Square perpSq = Sq(rel.x) + Sq(rel.y) + Sq(rel.z) - Sq(proj);
+
+	if (perpSq > Sq(radius)) return -1._f;
+
+	const Fix12i dist = -proj - RootOf(Sq(radius) - perpSq);
+
+	// The line has to start outside and reach the shape
+	if (dist < 0_f || dist > length) return -1._f;
+
+	return dist / length;
+}
+
+/* -------- -------- Normal IDs -------- -------- */
+
+// The triangle IDs of the collisions of AnalyticCollider
+enum : short
+{
+	UP,
+	DOWN,
+	POS_X,
+	NEG_X,
+	POS_Z,
+	NEG_Z,
+	SHAPE_NORMAL,
+	FIRST_ROUNDED // octahedral encoding of the other normals
+};
+
+constexpr int numRoundedSteps = 22; // along each axis of the octahedral encoding
+static_assert(FIRST_ROUNDED + numRoundedSteps * numRoundedSteps - 1 <= ColliderGrid::maxTriangleID);
+
+static Vector3 AxisNormal(short id)
+{
+	Vector3 res = {0_f, 0_f, 0_f};
+	(id <= DOWN ? res.y : id <= NEG_X ? res.x : res.z) = id & 1 ? -1._f : 1._f;
+
+	return res;
+}
+
+static Fix12i Sign(Fix12i x)
+{
+	return x < 0_f ? -1._f : 1._f;
+}
+
+// Folds the lower half of the octahedron onto the corners of the square and back
+static void Fold(Fix12i& u, Fix12i& v)
+{
+	const Fix12i foldedU = (1._f - Abs(v)) * Sign(u);
+	v = (1._f - Abs(u)) * Sign(v);
+	u = foldedU;
+}
+
+// From -1 to 1, to 0 to numRoundedSteps - 1 and back
+static int Round(Fix12i x)
+{
+	return ((x.val + 0x1000) * (numRoundedSteps - 1) + 0x1000) / 0x2000;
+}
+
+static Fix12i Unround(int step)
+{
+	return Fix12i(step * 0x2000 / (numRoundedSteps - 1) - 0x1000, as_raw);
+}
+
+static Vector3 RoundedNormal(short id)
+{
+	Fix12i u = Unround((id - FIRST_ROUNDED) / numRoundedSteps);
+	Fix12i v = Unround((id - FIRST_ROUNDED) % numRoundedSteps);
+	const Fix12i y = 1._f - Abs(u) - Abs(v);
+
+	if (y < 0_f) Fold(u, v);
+
+	return Normalized({u, y, v});
+}
+
+// Rounding u and v separately can be off by almost two steps in total,
+// so the neighbors of the rounded direction are tried as well
+static short RoundedID(const Vector3& normal)
+{
+	const Fix12i length = Abs(normal.x) + Abs(normal.y) + Abs(normal.z);
+
+	Fix12i u = normal.x / length;
+	Fix12i v = normal.z / length;
+
+	if (normal.y < 0_f) Fold(u, v);
+
+	const int roundedU = Round(u);
+	const int roundedV = Round(v);
+
+	short res = 0;
+	ClsnMath::Square bestDot = INT64_MIN;
+
+	for (int stepU = std::max(roundedU - 1, 0); stepU <= std::min(roundedU + 1, numRoundedSteps - 1); stepU++)
+	{
+		for (int stepV = std::max(roundedV - 1, 0); stepV <= std::min(roundedV + 1, numRoundedSteps - 1); stepV++)
+		{
+			const short id = FIRST_ROUNDED + stepU * numRoundedSteps + stepV;
+			const Vector3 candidate = RoundedNormal(id);
+
+			const ClsnMath::Square dot = static_cast<int64_t>(candidate.x.val) * normal.x.val
+				+ static_cast<int64_t>(candidate.y.val) * normal.y.val
+				+ static_cast<int64_t>(candidate.z.val) * normal.z.val;
+
+			if (dot > bestDot)
+			{
+				bestDot = dot;
+				res = id;
+			}
+		}
+	}
+
+	return res;
+}
+
+/* -------- -------- AnalyticCollider -------- -------- */
+
+const CLPS& AnalyticCollider::GetCLPS() const
+{
+	if (LEVEL_OVERLAY.clps)
+		return (*LEVEL_OVERLAY.clps)[param1 & 0xff];
+
+	static constexpr CLPS defaultCLPS = {};
+	return defaultCLPS;
+}
+
+int AnalyticCollider::InitResources()
+{
+	sizeX  = FromInt(ang.x);
+	sizeZ  = FromInt(ang.z);
+	height = FromInt(((param1 >> 8 & 0xff) + 1) * 16);
+
+	Setup();
+
+	if (!ColliderGrid::Add(*this, Bounds(), this))
+		Enable();
+
+	return 1;
+}
+
+int AnalyticCollider::CleanupResources()
+{
+	if (!ColliderGrid::Remove(*this))
+		Disable();
+
+	return 1;
+}
+
+Vector3 AnalyticCollider::ShapeNormal() const
+{
+	return Up();
+}
+
+AABB AnalyticCollider::Bounds() const
+{
+	return
+	{
+		{this->pos.x - sizeX, this->pos.y - height, this->pos.z - sizeZ},
+		{this->pos.x + sizeX, this->pos.y,          this->pos.z + sizeZ}
+	};
+}
+
+bool AnalyticCollider::BeforeBehavior() { return false; }
+bool AnalyticCollider::BeforeRender  () { return false; }
+
+void AnalyticCollider::GetSurfaceInfo(short triangleID, SurfaceInfo& res)
+{
+	GetNormal(triangleID, res.normal);
+	res.clps = GetCLPS();
+}
+
+void AnalyticCollider::GetNormal(short triangleID, Vector3& res)
+{
+	if (triangleID < SHAPE_NORMAL)
+		res = AxisNormal(triangleID);
+	else if (triangleID == SHAPE_NORMAL)
+		res = ShapeNormal();
+	else
+		res = RoundedNormal(triangleID);
+}
+
+void AnalyticCollider::GetTriangleOrigin(short triangleID, Vector3& res)
+{
+	res = this->pos;
+}
+
+const CLPS& AnalyticCollider::FloorCLPS() const { return GetCLPS(); }
+
+bool AnalyticCollider::DetectClsn(RaycastGround& ray)
+{
+	if (ray.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	Fix12i y;
+	Vector3 normal;
+
+	if (!FloorAt(ray.pos.x, ray.pos.z, y, normal)) return 0;
+	if (ray.pos.y < y) return 0;
+
+	return SetGroundResult(ray, y, normal);
+}
+
+short AnalyticCollider::NormalID(const Vector3& normal) const
+{
+	for (short id = UP; id < SHAPE_NORMAL; id++)
+		if (IsSamePoint(normal, AxisNormal(id)))
+			return id;
+
+	if (IsSamePoint(normal, ShapeNormal()))
+		return SHAPE_NORMAL;
+
+	return RoundedID(normal);
+}
+
+void AnalyticCollider::SetSurfaceInfo(SurfaceInfo& res, const Vector3& normal) const
+{
+	res.normal = normal;
+	res.clps = GetCLPS();
+}
+
+bool AnalyticCollider::SetGroundResult(RaycastGround& ray, Fix12i clsnPosY, const Vector3& normal)
+{
+	if (ray.hadCollision && ray.clsnPosY > clsnPosY) return 0;
+
+	ray.result.triangleID = NormalID(normal);
+	SetSurfaceInfo(ray.result.surfaceInfo, normal);
+	ray.clsnPosY = clsnPosY;
+	ray.hadCollision = true;
+
+	return 1;
+}
+
+bool AnalyticCollider::SetLineResult(RaycastLine& ray, const Vector3& clsnPos, const Vector3& normal)
+{
+	if (ray.hadCollision && ray.line.pos0.Dist(ray.clsnPos) < ray.line.pos0.Dist(clsnPos))
+		return 0;
+
+	ray.result.triangleID = NormalID(normal);
+	SetSurfaceInfo(ray.result.surfaceInfo, normal);
+	ray.hadCollision = true;
+	ray.clsnPos = clsnPos;
+
+	return 1;
+}
+
+unsigned AnalyticCollider::SetSphereResult(SphereClsn& sphere, const Vector3& pushback, const Vector3& normal)
+{
+	const short triangleID = NormalID(normal);
+
+	SetSurfaceInfo(sphere.result.surfaceInfo, normal);
+	sphere.result.triangleID = triangleID;
+
+	AddPushback(sphere, pushback);
+
+	sphere.resultFlags |= SphereClsn::COLLISION_EXISTS;
+
+	if (normal.y >= minFloorNormalY)
+	{
+		sphere.resultFlags |= SphereClsn::ON_GROUND;
+
+		SetSurfaceInfo(sphere.floorResult.surfaceInfo, normal);
+		sphere.floorResult.triangleID = triangleID;
+
+		sphere.storedNormal = normal;
+	}
+
+	return 1;
+}
+
+unsigned AnalyticCollider::PushSphereOut(SphereClsn& sphere, const Vector3& closestPoint)
+{
+	const Vector3 offset = sphere.pos - closestPoint;
+	const Square distSq = Sq(offset.x) + Sq(offset.y) + Sq(offset.z);
+
+	if (distSq >= Sq(sphere.radius)) return 0;
+
+	const Fix12i dist = RootOf(distSq);
+	const Vector3 normal = {offset.x / dist, offset.y / dist, offset.z / dist};
+
+	return SetSphereResult(sphere, Scaled(normal, sphere.radius - dist), normal);
+}
+
+/* -------- -------- BoxCollider -------- -------- */
+
+bool BoxCollider::FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const
+{
+	if (Abs(x - this->pos.x) > sizeX) return 0;
+	if (Abs(z - this->pos.z) > sizeZ) return 0;
+
+	y = this->pos.y;
+	normal = Up();
+
+	return 1;
+}
+
+struct SlabClip
+{
+	Fix12i tEnter = 0_f;
+	Fix12i tExit = 1._f;
+	Fix12i enterDir = 0_f; // the direction of the line along the axis it entered through
+	unsigned enterAxis = 3;
+
+	bool Clip(unsigned axis, Fix12i pos0, Fix12i v, Fix12i min, Fix12i max)
+	{
+		const Fix12i oldEnter = tEnter;
+
+		if (!ClipLine(pos0, v, min, max, tEnter, tExit))
+			return false;
+
+		if (tEnter != oldEnter)
+		{
+			enterDir = v;
+			enterAxis = axis;
+		}
+
+		return true;
+	}
+};
+
+bool BoxCollider::DetectClsn(RaycastLine& ray)
+{
+	if (ray.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Vector3& pos0 = ray.line.pos0;
+	const Vector3 v = ray.line.pos1 - pos0;
+
+	SlabClip clip;
+
+	if (!clip.Clip(0, pos0.x, v.x, this->pos.x - sizeX,   this->pos.x + sizeX)) return 0;
+	if (!clip.Clip(1, pos0.y, v.y, this->pos.y - height, this->pos.y))         return 0;
+	if (!clip.Clip(2, pos0.z, v.z, this->pos.z - sizeZ,   this->pos.z + sizeZ)) return 0;
+
+	// Lines that start inside the box don't collide with it
+	if (clip.enterAxis == 3) return 0;
+
+	Vector3 clsnPos = PointOnLine(pos0, v, clip.tEnter);
+	Vector3 normal = {0_f, 0_f, 0_f};
+	const Fix12i sign = clip.enterDir > 0_f ? -1._f : 1._f;
+
+	switch (clip.enterAxis)
+	{
+	case 0:
+		normal.x = sign;
+		clsnPos.x = this->pos.x + sizeX * sign;
+		break;
+	case 1:
+		normal.y = sign;
+		clsnPos.y = sign > 0_f ? this->pos.y : this->pos.y - height;
+		break;
+	default:
+		normal.z = sign;
+		clsnPos.z = this->pos.z + sizeZ * sign;
+		break;
+	}
+
+	return SetLineResult(ray, clsnPos, normal);
+}
+
+unsigned BoxCollider::DetectClsn(SphereClsn& sphere)
+{
+	if (sphere.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Fix12i bottom = this->pos.y - height;
+
+	const Vector3 closestPoint =
+	{
+		Clamp(sphere.pos.x, this->pos.x - sizeX, this->pos.x + sizeX),
+		Clamp(sphere.pos.y, bottom, this->pos.y),
+		Clamp(sphere.pos.z, this->pos.z - sizeZ, this->pos.z + sizeZ)
+	};
+
+	if (!IsSamePoint(closestPoint, sphere.pos))
+		return PushSphereOut(sphere, closestPoint);
+
+	// The center is inside, so the sphere is pushed out through the closest face
+	const Fix12i dx = sphere.pos.x - this->pos.x;
+	const Fix12i dz = sphere.pos.z - this->pos.z;
+
+	const Fix12i depthTop    = this->pos.y - sphere.pos.y;
+	const Fix12i depthBottom = sphere.pos.y - bottom;
+	const Fix12i depthX      = sizeX - Abs(dx);
+	const Fix12i depthZ      = sizeZ - Abs(dz);
+
+	Vector3 normal = Up();
+	Fix12i depth = depthTop;
+
+	if (depthBottom < depth) { normal = {0_f, -1._f, 0_f};                      depth = depthBottom; }
+	if (depthX      < depth) { normal = {dx < 0_f ? -1._f : 1._f, 0_f, 0_f};    depth = depthX;      }
+	if (depthZ      < depth) { normal = {0_f, 0_f, dz < 0_f ? -1._f : 1._f};    depth = depthZ;      }
+
+	return SetSphereResult(sphere, Scaled(normal, depth + sphere.radius), normal);
+}
+
+/* -------- -------- SlopeCollider -------- -------- */
+
+void SlopeCollider::Setup()
+{
+	const Fix12i rise = FromInt(static_cast<int8_t>(param1 >> 8) * 16);
+
+	gradient = sizeZ != 0_f ? (rise >> 1) / sizeZ : 0_f;
+
+	const Fix12i normalLength = RootOf(Sq(1._f) + Sq(gradient));
+	normal = {0_f, 1._f / normalLength, -gradient / normalLength};
+}
+
+Vector3 SlopeCollider::ShapeNormal() const
+{
+	return normal;
+}
+
+Fix12i SlopeCollider::HeightAt(Fix12i z) const
+{
+	return this->pos.y + (z - this->pos.z) * gradient;
+}
+
+AABB SlopeCollider::Bounds() const
+{
+	const Fix12i y0 = HeightAt(this->pos.z - sizeZ);
+	const Fix12i y1 = HeightAt(this->pos.z + sizeZ);
+
+	return
+	{
+		{this->pos.x - sizeX, y0 < y1 ? y0 : y1, this->pos.z - sizeZ},
+		{this->pos.x + sizeX, y0 < y1 ? y1 : y0, this->pos.z + sizeZ}
+	};
+}
+
+bool SlopeCollider::FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const
+{
+	if (Abs(x - this->pos.x) > sizeX) return 0;
+	if (Abs(z - this->pos.z) > sizeZ) return 0;
+
+	y = HeightAt(z);
+	normal = this->normal;
+
+	return 1;
+}
+
+bool SlopeCollider::DetectClsn(RaycastLine& ray)
+{
+	if (ray.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	// The vertical distances from the surface, which is only solid from above
+	const Fix12i above0 = ray.line.pos0.y - HeightAt(ray.line.pos0.z);
+	const Fix12i above1 = ray.line.pos1.y - HeightAt(ray.line.pos1.z);
+
+	if (above0 < 0_f || above1 >= 0_f) return 0;
+
+	const Vector3 v = ray.line.pos1 - ray.line.pos0;
+	Vector3 clsnPos = PointOnLine(ray.line.pos0, v, above0 / (above0 - above1));
+
+	if (Abs(clsnPos.x - this->pos.x) > sizeX) return 0;
+	if (Abs(clsnPos.z - this->pos.z) > sizeZ) return 0;
+
+	clsnPos.y = HeightAt(clsnPos.z);
+
+	return SetLineResult(ray, clsnPos, normal);
+}
+
+unsigned SlopeCollider::DetectClsn(SphereClsn& sphere)
+{
+	if (sphere.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	if (Abs(sphere.pos.x - this->pos.x) > sizeX) return 0;
+	if (Abs(sphere.pos.z - this->pos.z) > sizeZ) return 0;
+
+	const Fix12i above = sphere.pos.y - HeightAt(sphere.pos.z);
+	const Fix12i dist = above * normal.y;
+
+	if (!(dist < sphere.radius)) return 0;
+	if (!(dist > -5._f)) return 0;
+
+	// Floors push straight up like InfiniteFloor, steep slopes push along the normal
+	if (normal.y >= minFloorNormalY)
+		return SetSphereResult(sphere, {0_f, (sphere.radius - dist) / normal.y, 0_f}, normal);
+	else
+		return SetSphereResult(sphere, Scaled(normal, sphere.radius - dist), normal);
+}
+
+/* -------- -------- CylinderCollider -------- -------- */
+
+AABB CylinderCollider::Bounds() const
+{
+	return
+	{
+		{this->pos.x - sizeX, this->pos.y - height, this->pos.z - sizeX},
+		{this->pos.x + sizeX, this->pos.y,          this->pos.z + sizeX}
+	};
+}
+
+bool CylinderCollider::FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const
+{
+	if (Sq(x - this->pos.x) + Sq(z - this->pos.z) > Sq(sizeX)) return 0;
+
+	y = this->pos.y;
+	normal = Up();
+
+	return 1;
+}
+
+bool CylinderCollider::DetectClsn(RaycastLine& ray)
+{
+	if (ray.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Vector3& pos0 = ray.line.pos0;
+	const Vector3 v = ray.line.pos1 - pos0;
+	const Fix12i bottom = this->pos.y - height;
+
+	bool res = 0;
+
+	// The side
+	const Vector3 rel = {pos0.x - this->pos.x, 0_f, pos0.z - this->pos.z};
+
+	if (const Fix12i t = EnterRound(rel, {v.x, 0_f, v.z}, sizeX); t >= 0_f)
+	{
+		Vector3 clsnPos = PointOnLine(pos0, v, t);
+
+		if (bottom <= clsnPos.y && clsnPos.y <= this->pos.y)
+		{
+			// Moved onto the surface, because t isn't precise for long lines
+			const Vector3 normal = Normalized({clsnPos.x - this->pos.x, 0_f, clsnPos.z - this->pos.z});
+			clsnPos.x = this->pos.x + normal.x * sizeX;
+			clsnPos.z = this->pos.z + normal.z * sizeX;
+
+			res |= SetLineResult(ray, clsnPos, normal);
+		}
+	}
+
+	// The top
+	if (pos0.y >= this->pos.y && ray.line.pos1.y < this->pos.y)
+	{
+		Vector3 clsnPos = PointOnLine(pos0, v, (this->pos.y - pos0.y) / v.y);
+		clsnPos.y = this->pos.y;
+
+		if (Sq(clsnPos.x - this->pos.x) + Sq(clsnPos.z - this->pos.z) <= Sq(sizeX))
+			res |= SetLineResult(ray, clsnPos, Up());
+	}
+
+	return res;
+}
+
+unsigned CylinderCollider::DetectClsn(SphereClsn& sphere)
+{
+	if (sphere.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Fix12i bottom = this->pos.y - height;
+	const Fix12i dx = sphere.pos.x - this->pos.x;
+	const Fix12i dz = sphere.pos.z - this->pos.z;
+	const Fix12i horzDist = RootOf(Sq(dx) + Sq(dz));
+
+	Vector3 closestPoint = {sphere.pos.x, Clamp(sphere.pos.y, bottom, this->pos.y), sphere.pos.z};
+
+	if (horzDist > sizeX)
+	{
+		closestPoint.x = this->pos.x + dx / horzDist * sizeX;
+		closestPoint.z = this->pos.z + dz / horzDist * sizeX;
+	}
+
+	if (!IsSamePoint(closestPoint, sphere.pos))
+		return PushSphereOut(sphere, closestPoint);
+
+	const Fix12i depthTop    = this->pos.y - sphere.pos.y;
+	const Fix12i depthBottom = sphere.pos.y - bottom;
+	const Fix12i depthSide   = sizeX - horzDist;
+
+	Vector3 normal = Up();
+	Fix12i depth = depthTop;
+
+	if (depthBottom < depth) { normal = {0_f, -1._f, 0_f}; depth = depthBottom; }
+
+	if (depthSide < depth)
+	{
+		normal = Normalized({dx, 0_f, dz});
+		depth = depthSide;
+	}
+
+	return SetSphereResult(sphere, Scaled(normal, depth + sphere.radius), normal);
+}
+
+/* -------- -------- SphereCollider -------- -------- */
+
+AABB SphereCollider::Bounds() const
+{
+	const Vector3 radius = {sizeX, sizeX, sizeX};
+
+	return {this->pos - radius, this->pos + radius};
+}
+
+bool SphereCollider::FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const
+{
+	const Fix12i dx = x - this->pos.x;
+	const Fix12i dz = z - this->pos.z;
+	const Square horzDistSq = Sq(dx) + Sq(dz);
+
+	if (horzDistSq > Sq(sizeX)) return 0;
+
+	const Fix12i dy = RootOf(Sq(sizeX) - horzDistSq);
+
+	y = this->pos.y + dy;
+	normal = {dx / sizeX, dy / sizeX, dz / sizeX};
+
+	return 1;
+}
+
+bool SphereCollider::DetectClsn(RaycastLine& ray)
+{
+	if (ray.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Vector3 v = ray.line.pos1 - ray.line.pos0;
+	const Fix12i t = EnterRound(ray.line.pos0 - this->pos, v, sizeX);
+
+	if (t < 0_f) return 0;
+
+	const Vector3 normal = Normalized(PointOnLine(ray.line.pos0, v, t) - this->pos);
+
+	return SetLineResult(ray, this->pos + Scaled(normal, sizeX), normal);
+}
+
+unsigned SphereCollider::DetectClsn(SphereClsn& sphere)
+{
+	if (sphere.ShouldPassThrough(GetCLPS(), false)) return 0;
+
+	const Vector3 offset = sphere.pos - this->pos;
+	const Square distSq = Sq(offset.x) + Sq(offset.y) + Sq(offset.z);
+
+	if (distSq >= Sq(sizeX + sphere.radius)) return 0;
+
+	const Vector3 normal = Normalized(offset);
+
+	return SetSphereResult(sphere, Scaled(normal, sizeX + sphere.radius - RootOf(distSq)), normal);
+}
+
+/* -------- -------- MovingPlatform -------- -------- */
+
+void MovingPlatform::Setup()
+{
+	height = thickness;
+	startPos = this->pos;
+	offset = 0_f;
+	movingBack = false;
+}
+
+bool MovingPlatform::BeforeBehavior()
+{
+	const Fix12i distance = FromInt((param1 >> 10 & 0x3f) * 64);
+	const Fix12i oldOffset = offset;
+
+	offset += movingBack ? -speed : speed;
+
+	if (offset >= distance)
+	{
+		offset = distance;
+		movingBack = true;
+	}
+	else if (offset <= 0_f)
+	{
+		offset = 0_f;
+		movingBack = false;
+	}
+
+	Vector3 newPos = startPos;
+
+	switch (param1 >> 8 & 3)
+	{
+	case 0:  newPos.x += offset; break;
+	case 2:  newPos.z += offset; break;
+	default: newPos.y += offset; break;
+	}
+
+	// The player is carried if it's standing on the platform. Vanilla platforms
+	// carry it with the floor tracking of mesh colliders, which this collider
+	// isn't, so the player is moved directly instead. That's safe because it's
+	// moved by at most the speed of the platform, which is much less than the
+	// radius of the player's collision sphere, so the player's own collision
+	// checks push it out of any wall it was moved into, either later on this
+	// frame or on the next one if its behavior already ran.
+	if (Player* player = PLAYER_ARR[0]; player && offset != oldOffset)
+	{
+		if (Abs(player->pos.y - this->pos.y) <= 1._f &&
+			Abs(player->pos.x - this->pos.x) <= sizeX &&
+			Abs(player->pos.z - this->pos.z) <= sizeZ)
+		{
+			player->pos += newPos - this->pos;
+		}
+	}
+
+	if (offset != oldOffset)
+	{
+		this->pos = newPos;
+		ColliderGrid::Move(*this, Bounds());
+	}
+
+	return false;
+}
+
+/* -------- -------- DL entry points -------- -------- */
+
+// The entries init() replaces, which cleanup() puts back
+struct SavedEntry
+{
+	SpawnInfo* spawnInfo;
+	uint16_t actorID;
+};
+
+template<class T>
+constinit SavedEntry savedEntry = {};
+
+template<class T>
+static void Register()
+{
+	savedEntry<T> = {ACTOR_SPAWN_TABLE[T::staticActorID], OBJ_TO_ACTOR_ID_TABLE[T::staticActorID]};
+
+	ACTOR_SPAWN_TABLE[T::staticActorID] = &T::spawnData;
+	OBJ_TO_ACTOR_ID_TABLE[T::staticActorID] = T::staticActorID;
+}
+
+template<class T>
+static void Unregister()
+{
+	ACTOR_SPAWN_TABLE[T::staticActorID] = savedEntry<T>.spawnInfo;
+	OBJ_TO_ACTOR_ID_TABLE[T::staticActorID] = savedEntry<T>.actorID;
+}
+
+void init()
+{
+	Register<BoxCollider>();
+	Register<SlopeCollider>();
+	Register<CylinderCollider>();
+	Register<SphereCollider>();
+	Register<MovingPlatform>();
+}
+
+void cleanup()
+{
+	Unregister<MovingPlatform>();
+	Unregister<SphereCollider>();
+	Unregister<CylinderCollider>();
+	Unregister<SlopeCollider>();
+	Unregister<BoxCollider>();
+}
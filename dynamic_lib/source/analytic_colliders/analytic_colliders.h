@@ -0,0 +1,139 @@
+#ifndef ANALYTIC_COLLIDERS_INCLUDED
+#define ANALYTIC_COLLIDERS_INCLUDED
+
+#include "SM64DS_PI.h"
+#include "collider_grid.h"
+
+// Colliders for simple shapes whose collision is computed directly from the shape
+// instead of from triangles, like InfiniteFloor. All shapes are axis aligned.
+//
+// param1 & 0xff is the index of the CLPS of the surface, the size of the shape is
+// stored in the X and Z rotation (parameters 2 and 3) and in param1 >> 8:
+//
+// BoxCollider:      half width (X), half depth (Z), height in units of 16 minus one
+// SlopeCollider:    half width (X), half depth (Z), signed rise along Z in units of 16
+// CylinderCollider: radius,         unused,         height in units of 16 minus one
+// SphereCollider:   radius,         unused,         unused
+// MovingPlatform:   half width (X), half depth (Z), axis (bits 0-1) and distance in
+//                                                   units of 64 (bits 2-7) to travel
+//
+// The position of boxes, slopes, cylinders and platforms is the center of the top.
+//
+// The colliders are added to the ColliderGrid of this DL, so collision queries only
+// test the ones nearby, and the grid caches where their floors are.
+
+struct AnalyticCollider : public Actor, public MeshColliderBase, public ColliderGrid::FloorShape
+{
+	const CLPS& GetCLPS() const;
+
+	// Called by InitResources after the size has been read, before the collider is added
+	virtual void Setup() {}
+	virtual AABB Bounds() const;
+
+	// The normal of the flat surface of shapes that aren't axis aligned
+	virtual Vector3 ShapeNormal() const;
+
+	virtual int InitResources() final override;
+	virtual int CleanupResources() final override;
+	virtual bool BeforeBehavior() override;
+	virtual bool BeforeRender() override;
+	virtual void GetSurfaceInfo(short triangleID, SurfaceInfo& res) final override;
+	virtual void GetNormal(short triangleID, Vector3& res) final override;
+	virtual void GetTriangleOrigin(short triangleID, Vector3& res) final override;
+	using MeshColliderBase::DetectClsn;
+	virtual bool DetectClsn(RaycastGround& ray) final override;
+	virtual const CLPS& FloorCLPS() const final override;
+	virtual bool SetGroundResult(RaycastGround& ray, Fix12i clsnPosY, const Vector3& normal) final override;
+
+protected:
+	Fix12i sizeX;
+	Fix12i sizeZ;
+	Fix12i height;
+
+	// The triangle ID of a collision encodes its normal, so that it can be looked up
+	// for as long as the result is kept, which works for curved surfaces as well. The
+	// normals of the faces of the shapes are exact, the others are rounded to one of
+	// 484 directions, which is off by up to 8 degrees. Results get the exact normal
+	// when they're found, so only later lookups of the surface info are rounded.
+	short NormalID(const Vector3& normal) const;
+	void SetSurfaceInfo(SurfaceInfo& res, const Vector3& normal) const;
+
+	bool SetLineResult(RaycastLine& ray, const Vector3& clsnPos, const Vector3& normal);
+	unsigned SetSphereResult(SphereClsn& sphere, const Vector3& pushback, const Vector3& normal);
+
+	// Pushes the sphere away from the closest point of the shape, which must not be its center
+	unsigned PushSphereOut(SphereClsn& sphere, const Vector3& closestPoint);
+};
+
+struct BoxCollider : public AnalyticCollider
+{
+	static constexpr uint16_t staticActorID = 563;
+	static SpawnInfo spawnData;
+
+	using AnalyticCollider::DetectClsn;
+	virtual bool FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const override;
+	virtual bool DetectClsn(RaycastLine& ray) override;
+	virtual unsigned DetectClsn(SphereClsn& sphere) override;
+};
+
+struct SlopeCollider : public AnalyticCollider
+{
+	static constexpr uint16_t staticActorID = 564;
+	static SpawnInfo spawnData;
+
+	Fix12i gradient;
+	Vector3 normal;
+
+	Fix12i HeightAt(Fix12i z) const;
+
+	virtual void Setup() final override;
+	virtual AABB Bounds() const final override;
+	virtual Vector3 ShapeNormal() const final override;
+	using AnalyticCollider::DetectClsn;
+	virtual bool FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const final override;
+	virtual bool DetectClsn(RaycastLine& ray) final override;
+	virtual unsigned DetectClsn(SphereClsn& sphere) final override;
+};
+
+struct CylinderCollider : public AnalyticCollider
+{
+	static constexpr uint16_t staticActorID = 565;
+	static SpawnInfo spawnData;
+
+	virtual AABB Bounds() const final override;
+	using AnalyticCollider::DetectClsn;
+	virtual bool FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const final override;
+	virtual bool DetectClsn(RaycastLine& ray) final override;
+	virtual unsigned DetectClsn(SphereClsn& sphere) final override;
+};
+
+struct SphereCollider : public AnalyticCollider
+{
+	static constexpr uint16_t staticActorID = 566;
+	static SpawnInfo spawnData;
+
+	virtual AABB Bounds() const final override;
+	using AnalyticCollider::DetectClsn;
+	virtual bool FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const final override;
+	virtual bool DetectClsn(RaycastLine& ray) final override;
+	virtual unsigned DetectClsn(SphereClsn& sphere) final override;
+};
+
+// A thin box that moves back and forth along an axis and carries the player with it
+struct MovingPlatform : public BoxCollider
+{
+	static constexpr uint16_t staticActorID = 567;
+	static SpawnInfo spawnData;
+
+	static constexpr Fix12i speed = 8._f;
+	static constexpr Fix12i thickness = 32._f;
+
+	Vector3 startPos;
+	Fix12i offset;
+	bool movingBack;
+
+	virtual void Setup() final override;
+	virtual bool BeforeBehavior() final override;
+};
+
+#endif
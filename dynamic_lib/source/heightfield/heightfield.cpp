@@ -0,0 +1,327 @@
+#include "heightfield.h"
+#include "clsn_math.h"
+#include <algorithm>
+
+using namespace ClsnMath;
+
+SpawnInfo Heightfield::spawnData =
+{
+	+[]() -> ActorBase* { return new Heightfield; },
+	staticActorID, // behavPriority
+	staticActorID, // renderPriority
+	0,      // flags
+	0_f,    // rangeOffsetY
+	-1._f,  // range
+	0_f,    // drawDist
+	0_f     // unkc0
+};
+
+// Surfaces with a steeper normal than this are walls
+constexpr Fix12i minFloorNormalY = 0.7_f;
+
+const CLPS& Heightfield::GetCLPS(unsigned cellID) const
+{
+	if (LEVEL_OVERLAY.clps)
+		return (*LEVEL_OVERLAY.clps)[clpsIDs[cellID]];
+
+	static constexpr CLPS defaultCLPS = {};
+	return defaultCLPS;
+}
+
+Fix12i Heightfield::CornerHeight(unsigned x, unsigned z) const
+{
+	const int height = heights[z * (header->numCellsX + 1) + x];
+
+	return this->pos.y + Fix12i(height << header->heightShift, as_raw);
+}
+
+Fix12i Heightfield::HeightInCell(unsigned cellX, unsigned cellZ, Fix12i u, Fix12i v) const
+{
+	const Fix12i h00 = CornerHeight(cellX,     cellZ);
+	const Fix12i h10 = CornerHeight(cellX + 1, cellZ);
+	const Fix12i h01 = CornerHeight(cellX,     cellZ + 1);
+	const Fix12i h11 = CornerHeight(cellX + 1, cellZ + 1);
+
+	const Fix12i h0 = h00 + (h10 - h00) * u;
+	const Fix12i h1 = h01 + (h11 - h01) * u;
+
+	return h0 + (h1 - h0) * v;
+}
+
+Vector3 Heightfield::NormalInCell(unsigned cellX, unsigned cellZ, Fix12i u, Fix12i v) const
+{
+	const Fix12i h00 = CornerHeight(cellX,     cellZ);
+	const Fix12i h10 = CornerHeight(cellX + 1, cellZ);
+	const Fix12i h01 = CornerHeight(cellX,     cellZ + 1);
+	const Fix12i h11 = CornerHeight(cellX + 1, cellZ + 1);
+
+	// The slopes of the surface along the cell at (u, v)
+	const Fix12i slopeU = (h10 - h00) + ((h11 - h01) - (h10 - h00)) * v;
+	const Fix12i slopeV = (h01 - h00) + ((h11 - h10) - (h01 - h00)) * u;
+
+	return Normalized({-slopeU / header->cellSize, 1._f, -slopeV / header->cellSize});
+}
+
+// Splits a coordinate into the index of its cell and the position in the cell
+static bool SplitGridCoord(Fix12i coord, unsigned numCells, unsigned& cell, Fix12i& frac)
+{
+	if (coord < 0_f || coord > FromInt(numCells)) return false;
+
+	cell = coord.val >> 12;
+	frac = Fix12i(coord.val & 0xfff, as_raw);
+
+	// The far edge belongs to the last cell
+	if (cell == numCells)
+	{
+		cell--;
+		frac = 1._f;
+	}
+
+	return true;
+}
+
+// Like SplitGridCoord, but clamps coordinates outside of the grid
+static unsigned CellIndex(Fix12i coord, unsigned numCells)
+{
+	if (coord < 0_f) return 0;
+
+	return std::min<unsigned>(coord.val >> 12, numCells - 1);
+}
+
+bool Heightfield::FindCell(const Vector3& pos, unsigned& cellX, unsigned& cellZ, Fix12i& u, Fix12i& v) const
+{
+	return SplitGridCoord((pos.x - this->pos.x) / header->cellSize, header->numCellsX, cellX, u)
+		&& SplitGridCoord((pos.z - this->pos.z) / header->cellSize, header->numCellsZ, cellZ, v);
+}
+
+// The vertical distance from the surface of the given cell, which is extended past its edges
+Fix12i Heightfield::HeightAbove(const Vector3& pos, unsigned cellX, unsigned cellZ) const
+{
+	const Fix12i u = Clamp((pos.x - this->pos.x) / header->cellSize - FromInt(cellX), 0_f, 1._f);
+	const Fix12i v = Clamp((pos.z - this->pos.z) / header->cellSize - FromInt(cellZ), 0_f, 1._f);
+
+	return pos.y - HeightInCell(cellX, cellZ, u, v);
+}
+
+int Heightfield::InitResources()
+{
+	const char* data = file.Construct(param1 & 0xffff).Load();
+
+	header = reinterpret_cast<const Header*>(data);
+
+	const unsigned numCells = header->numCellsX * header->numCellsZ;
+	const unsigned numCorners = (header->numCellsX + 1) * (header->numCellsZ + 1);
+
+	if (header->magic != Header::expectedMagic || numCells == 0 || numCells > Header::maxCells)
+		Crash();
+
+	heights = reinterpret_cast<const int16_t*>(data + sizeof(Header));
+	clpsIDs = reinterpret_cast<const uint8_t*>(heights + numCorners);
+
+	const auto [minHeight, maxHeight] = std::minmax_element(heights, heights + numCorners);
+
+	minY = this->pos.y + Fix12i(*minHeight << header->heightShift, as_raw);
+	maxY = this->pos.y + Fix12i(*maxHeight << header->heightShift, as_raw);
+
+	Enable();
+
+	return 1;
+}
+
+int Heightfield::CleanupResources()
+{
+	Disable();
+	file.Release();
+
+	return 1;
+}
+
+bool Heightfield::BeforeBehavior() { return false; }
+bool Heightfield::BeforeRender  () { return false; }
+
+void Heightfield::GetSurfaceInfo(short triangleID, SurfaceInfo& res)
+{
+	GetNormal(triangleID, res.normal);
+	res.clps = GetCLPS(triangleID);
+}
+
+void Heightfield::GetNormal(short triangleID, Vector3& res)
+{
+	res = NormalInCell(triangleID % header->numCellsX, triangleID / header->numCellsX, 0.5_f, 0.5_f);
+}
+
+void Heightfield::GetTriangleOrigin(short triangleID, Vector3& res)
+{
+	const unsigned cellX = triangleID % header->numCellsX;
+	const unsigned cellZ = triangleID / header->numCellsX;
+
+	res.x = this->pos.x + header->cellSize * FromInt(cellX);
+	res.y = CornerHeight(cellX, cellZ);
+	res.z = this->pos.z + header->cellSize * FromInt(cellZ);
+}
+
+bool Heightfield::DetectClsn(RaycastGround& ray)
+{
+	if (ray.pos.y < minY) return 0;
+
+	unsigned cellX, cellZ;
+	Fix12i u, v;
+
+	if (!FindCell(ray.pos, cellX, cellZ, u, v)) return 0;
+
+	const unsigned cellID = cellZ * header->numCellsX + cellX;
+
+	if (ray.ShouldPassThrough(GetCLPS(cellID), false)) return 0;
+
+	const Fix12i y = HeightInCell(cellX, cellZ, u, v);
+
+	if (ray.pos.y < y) return 0;
+	if (ray.hadCollision && ray.clsnPosY > y) return 0;
+
+	GetSurfaceInfo(cellID, ray.result.surfaceInfo);
+	ray.result.triangleID = cellID;
+	ray.clsnPosY = y;
+	ray.hadCollision = true;
+
+	return 1;
+}
+
+// Walks through the cells below the line in order, starting at pos0,
+// and stops at the first one where the line goes through the surface
+bool Heightfield::DetectClsn(RaycastLine& ray)
+{
+	const Vector3& pos0 = ray.line.pos0;
+	const Vector3 v = ray.line.pos1 - pos0;
+
+	// The surface is only solid from above
+	if (pos0.y < minY || ray.line.pos1.y > maxY) return 0;
+
+	const Fix12i cellSize = header->cellSize;
+	const unsigned numCellsX = header->numCellsX;
+	const unsigned numCellsZ = header->numCellsZ;
+
+	Fix12i t = 0_f;
+	Fix12i tEnd = 1._f;
+
+	if (!ClipLine(pos0.x, v.x, this->pos.x, this->pos.x + cellSize * FromInt(numCellsX), t, tEnd)) return 0;
+	if (!ClipLine(pos0.z, v.z, this->pos.z, this->pos.z + cellSize * FromInt(numCellsZ), t, tEnd)) return 0;
+
+	const Vector3 start = PointOnLine(pos0, v, t);
+
+	unsigned cellX = CellIndex((start.x - this->pos.x) / cellSize, numCellsX);
+	unsigned cellZ = CellIndex((start.z - this->pos.z) / cellSize, numCellsZ);
+
+	// Like in ClipLine, lines that barely move along an axis don't cross cell edges along it
+	const bool stepsX = Abs(v.x) >= 1._f;
+	const bool stepsZ = Abs(v.z) >= 1._f;
+
+	Fix12i above0 = HeightAbove(start, cellX, cellZ);
+
+	while (true)
+	{
+		// The line leaves the cell when it crosses the next edge along X or Z
+		const Fix12i edgeX = this->pos.x + cellSize * FromInt(cellX + (v.x > 0_f));
+		const Fix12i edgeZ = this->pos.z + cellSize * FromInt(cellZ + (v.z > 0_f));
+
+		const Fix12i tNextX = stepsX ? (edgeX - pos0.x) / v.x : tEnd;
+		const Fix12i tNextZ = stepsZ ? (edgeZ - pos0.z) / v.z : tEnd;
+		const Fix12i tNext = std::min({tNextX, tNextZ, tEnd});
+
+		const Fix12i above1 = HeightAbove(PointOnLine(pos0, v, tNext), cellX, cellZ);
+		const unsigned cellID = cellZ * numCellsX + cellX;
+
+		if (above0 >= 0_f && above1 < 0_f && !ray.ShouldPassThrough(GetCLPS(cellID), false))
+		{
+			const Fix12i tClsn = t + (tNext - t) * (above0 / (above0 - above1));
+			Vector3 clsnPos = PointOnLine(pos0, v, tClsn);
+			clsnPos.y -= HeightAbove(clsnPos, cellX, cellZ);
+
+			if (ray.hadCollision && pos0.Dist(ray.clsnPos) < pos0.Dist(clsnPos))
+				return 0;
+
+			GetSurfaceInfo(cellID, ray.result.surfaceInfo);
+			ray.result.triangleID = cellID;
+			ray.hadCollision = true;
+			ray.clsnPos = clsnPos;
+
+			return 1;
+		}
+
+		if (tNext >= tEnd) return 0;
+
+		if (tNext == tNextX)
+		{
+			if (v.x > 0_f ? cellX + 1 >= numCellsX : cellX == 0) return 0;
+			cellX += v.x > 0_f ? 1 : -1;
+		}
+		else
+		{
+			if (v.z > 0_f ? cellZ + 1 >= numCellsZ : cellZ == 0) return 0;
+			cellZ += v.z > 0_f ? 1 : -1;
+		}
+
+		t = tNext;
+		above0 = HeightAbove(PointOnLine(pos0, v, t), cellX, cellZ);
+	}
+}
+
+// Only the cell below the center of the sphere is checked
+unsigned Heightfield::DetectClsn(SphereClsn& sphere)
+{
+	if (sphere.pos.y - sphere.radius > maxY) return 0;
+
+	unsigned cellX, cellZ;
+	Fix12i u, v;
+
+	if (!FindCell(sphere.pos, cellX, cellZ, u, v)) return 0;
+
+	const unsigned cellID = cellZ * header->numCellsX + cellX;
+
+	if (sphere.ShouldPassThrough(GetCLPS(cellID), false)) return 0;
+
+	const Vector3 normal = NormalInCell(cellX, cellZ, u, v);
+	const Fix12i dist = (sphere.pos.y - HeightInCell(cellX, cellZ, u, v)) * normal.y;
+
+	if (!(dist < sphere.radius)) return 0;
+	if (!(dist > -5._f)) return 0;
+
+	GetSurfaceInfo(cellID, sphere.result.surfaceInfo);
+	sphere.result.triangleID = cellID;
+	sphere.resultFlags |= SphereClsn::COLLISION_EXISTS;
+
+	// Floors push straight up like InfiniteFloor, steep slopes push along the normal
+	if (normal.y >= minFloorNormalY)
+	{
+		AddPushback(sphere, {0_f, (sphere.radius - dist) / normal.y, 0_f});
+
+		sphere.resultFlags |= SphereClsn::ON_GROUND;
+
+		GetSurfaceInfo(cellID, sphere.floorResult.surfaceInfo);
+		sphere.floorResult.triangleID = cellID;
+
+		sphere.storedNormal = normal;
+	}
+	else
+		AddPushback(sphere, Scaled(normal, sphere.radius - dist));
+
+	return 1;
+}
+
+// The entries init() replaces, which cleanup() puts back
+static constinit SpawnInfo* savedSpawnInfo = nullptr;
+static constinit uint16_t savedActorID = 0;
+
+void init()
+{
+	savedSpawnInfo = ACTOR_SPAWN_TABLE[Heightfield::staticActorID];
+	savedActorID = OBJ_TO_ACTOR_ID_TABLE[Heightfield::staticActorID];
+
+	ACTOR_SPAWN_TABLE[Heightfield::staticActorID] = &Heightfield::spawnData;
+	OBJ_TO_ACTOR_ID_TABLE[Heightfield::staticActorID] = Heightfield::staticActorID;
+}
+
+void cleanup()
+{
+	ACTOR_SPAWN_TABLE[Heightfield::staticActorID] = savedSpawnInfo;
+	OBJ_TO_ACTOR_ID_TABLE[Heightfield::staticActorID] = savedActorID;
+}
@@ -0,0 +1,59 @@
+#ifndef HEIGHTFIELD_INCLUDED
+#define HEIGHTFIELD_INCLUDED
+
+#include "SM64DS_PI.h"
+
+// A collider for terrain made of a grid of heights, which is loaded from the file with
+// the overlay 0 ID param1. The surface is interpolated bilinearly between the corners
+// of each cell and is only solid from above. The position of the actor is the corner
+// of the grid with the lowest X and Z, and the heights are relative to it.
+// tools/heightfield converts a grayscale image to such a file.
+//
+// The triangle ID of a collision is the index of its cell.
+struct Heightfield : public Actor, public MeshColliderBase
+{
+	static constexpr uint16_t staticActorID = 568;
+	static SpawnInfo spawnData;
+
+	// Followed by the heights of the (numCellsX + 1) * (numCellsZ + 1) corners
+	// as int16_t, row by row along X, and the CLPS index of each cell as uint8_t
+	struct Header
+	{
+		static constexpr unsigned expectedMagic = 0x444c4648; // "HFLD"
+		static constexpr unsigned maxCells = 0x8000;
+
+		unsigned magic;
+		uint16_t numCellsX;
+		uint16_t numCellsZ;
+		Fix12i cellSize;
+		uint8_t heightShift; // the heights are raw Fix12i values shifted right by this
+		uint8_t padding[3];
+	};
+
+	SharedFilePtr file;
+	const Header* header;
+	const int16_t* heights;
+	const uint8_t* clpsIDs;
+	Fix12i minY;
+	Fix12i maxY;
+
+	const CLPS& GetCLPS(unsigned cellID) const;
+	Fix12i CornerHeight(unsigned x, unsigned z) const;
+	Fix12i HeightInCell(unsigned cellX, unsigned cellZ, Fix12i u, Fix12i v) const;
+	Vector3 NormalInCell(unsigned cellX, unsigned cellZ, Fix12i u, Fix12i v) const;
+	bool FindCell(const Vector3& pos, unsigned& cellX, unsigned& cellZ, Fix12i& u, Fix12i& v) const;
+	Fix12i HeightAbove(const Vector3& pos, unsigned cellX, unsigned cellZ) const;
+
+	virtual int InitResources() final override;
+	virtual int CleanupResources() final override;
+	virtual bool BeforeBehavior() final override;
+	virtual bool BeforeRender() final override;
+	virtual void GetSurfaceInfo(short triangleID, SurfaceInfo& res) final override;
+	virtual void GetNormal(short triangleID, Vector3& res) final override;
+	virtual void GetTriangleOrigin(short triangleID, Vector3& res) final override;
+	virtual bool DetectClsn(RaycastGround& ray) final override;
+	virtual bool DetectClsn(RaycastLine& ray) final override;
+	virtual unsigned DetectClsn(SphereClsn& sphere) final override;
+};
+
+#endif
@@ -0,0 +1,6 @@
+// libc comes from dynamic_lib/Makefile and the table from runtime_table.s,
+// so there's nothing to do when the runtime is loaded.
+
+void init() {}
+
+void cleanup() {}
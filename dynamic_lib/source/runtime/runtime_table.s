@@ -0,0 +1,17 @@
+#include "runtime.h"
+
+#define RUNTIME_EXPORT(symbol, function) .set numExports, numExports + 1
+	.set numExports, 0
+#include "runtime_exports.h"
+#undef RUNTIME_EXPORT
+
+@ Found by the loader through this symbol
+	.section .rodata.runtimeExports, "a"
+	.balign 4
+	.global runtimeExports
+runtimeExports:
+	.word RUNTIME_VERSION << 16 | numExports
+
+#define RUNTIME_EXPORT(symbol, function) .word symbol
+#include "runtime_exports.h"
+#undef RUNTIME_EXPORT
@@ -76,6 +76,19 @@ constinit auto script = NewScript().
 	EnableAmbientSoundEffects() (600).
 	SetCamShakeIntensity(10_deg)(600).
 
+	SpawnActor(0x12f, 0, {-1187, 500, 6167}, 0_deg, 0) (610).
+	SpawnActor(0x12f, 1, {-1287, 500, 6167}, 0_deg, 0, SpawnQueue::HIGH) (610).
+
+	WaitUntil([] // resets the count when it's done, so that the script can run again
+	{
+		static unsigned numWaits = 0;
+		if (++numWaits < 10) return false;
+
+		numWaits = 0;
+		return true;
+	}) (615).
+	Print("\nWaited for 9 frames at frame ") (615). PrintFrameCounter() (615).
+
 	Print("\nDone!\n") (630).
 
 	End();
@@ -0,0 +1,175 @@
+#include "../source/dma.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr uintptr_t mainRamStart = 0x02000000;
+constexpr uintptr_t mainRamEnd   = 0x02400000;
+constexpr uintptr_t dtcmStart    = 0x023c0000;
+constexpr uintptr_t dtcmEnd      = 0x023c4000;
+
+constexpr uintptr_t cacheLineSize = 32;
+
+struct DMAChannel
+{
+	const void* src;
+	void* dest;
+	unsigned control;
+
+	static constexpr unsigned ENABLE    = 1u << 31;
+	static constexpr unsigned WORDS     = 1 << 26;
+	static constexpr unsigned SRC_FIXED = 2 << 23;
+};
+
+static volatile DMAChannel& GetChannel()
+{
+	return reinterpret_cast<volatile DMAChannel*>(0x040000b0)[DMA::channel];
+}
+
+static volatile unsigned& GetFillData()
+{
+	return reinterpret_cast<volatile unsigned*>(0x040000e0)[DMA::channel];
+}
+
+// An interrupt handler that uses the channel between the writes to its registers
+// would replace the source and destination of the transfer, so they're written
+// with interrupts disabled.
+class InterruptsDisabled
+{
+	static volatile unsigned& IME()
+	{
+		return *reinterpret_cast<volatile unsigned*>(0x04000208);
+	}
+
+	const unsigned prevIME = IME();
+
+public:
+	InterruptsDisabled()  { IME() = 0; }
+	~InterruptsDisabled() { IME() = prevIME; }
+};
+
+static bool IsAccessible(const void* ptr, size_t size)
+{
+	const uintptr_t start = reinterpret_cast<uintptr_t>(ptr);
+	const uintptr_t end = start + size;
+
+	return start >= mainRamStart && end <= mainRamEnd && (end <= dtcmStart || start >= dtcmEnd);
+}
+
+static void DrainWriteBuffer()
+{
+	asm volatile("mcr p15, 0, %0, c7, c10, 4" :: "r" (0) : "memory");
+}
+
+// Writes the cache lines that overlap the range back to memory
+static void CleanDCache(const char* start, const char* end)
+{
+	for (uintptr_t addr = reinterpret_cast<uintptr_t>(start) & -cacheLineSize;
+		addr < reinterpret_cast<uintptr_t>(end); addr += cacheLineSize)
+	{
+		asm volatile("mcr p15, 0, %0, c7, c10, 1" :: "r" (addr) : "memory");
+	}
+
+	DrainWriteBuffer();
+}
+
+// Discards the cache lines in the range, which needs to start and end at a cache line boundary
+static void InvalidateDCache(char* start, char* end)
+{
+	for (char* addr = start; addr < end; addr += cacheLineSize)
+		asm volatile("mcr p15, 0, %0, c7, c6, 1" :: "r" (addr) : "memory");
+}
+
+// Splits off the parts of the destination that share a cache line with
+// other data, so that they can be handled by the CPU instead
+static size_t GetHeadSize(const char* dest, size_t size)
+{
+	return std::min<size_t>(-reinterpret_cast<uintptr_t>(dest) & (cacheLineSize - 1), size);
+}
+
+bool DMA::CanCopy(const void* dest, const void* src, size_t size)
+{
+	return ((reinterpret_cast<uintptr_t>(dest) ^ reinterpret_cast<uintptr_t>(src)) & 3) == 0 &&
+		IsAccessible(dest, size) && IsAccessible(src, size);
+}
+
+bool DMA::CanFill(const void* dest, size_t size)
+{
+	return IsAccessible(dest, size);
+}
+
+void DMA::StartCopy(void* dest, const void* src, size_t size)
+{
+	Wait();
+
+	char* d = static_cast<char*>(dest);
+	const char* s = static_cast<const char*>(src);
+
+	const size_t head = GetHeadSize(d, size);
+	std::memcpy(d, s, head);
+
+	d += head;
+	s += head;
+	size -= head;
+
+	const size_t tail = size & (cacheLineSize - 1);
+	size -= tail;
+	std::memcpy(d + size, s + size, tail);
+
+	if (size == 0) return;
+
+	CleanDCache(s, s + size);
+	InvalidateDCache(d, d + size);
+
+	const InterruptsDisabled interruptsDisabled;
+	volatile DMAChannel& channel = GetChannel();
+
+	Wait(); // for a transfer an interrupt handler started after the first wait
+	channel.src = s;
+	channel.dest = d;
+	channel.control = DMAChannel::ENABLE | DMAChannel::WORDS | size / 4;
+}
+
+void DMA::StartFill(void* dest, uint8_t val, size_t size)
+{
+	Wait();
+
+	char* d = static_cast<char*>(dest);
+
+	const size_t head = GetHeadSize(d, size);
+	std::memset(d, val, head);
+
+	d += head;
+	size -= head;
+
+	const size_t tail = size & (cacheLineSize - 1);
+	size -= tail;
+	std::memset(d + size, val, tail);
+
+	if (size == 0) return;
+
+	DrainWriteBuffer();
+	InvalidateDCache(d, d + size);
+
+	const InterruptsDisabled interruptsDisabled;
+	volatile DMAChannel& channel = GetChannel();
+	volatile unsigned& fillData = GetFillData();
+
+	Wait(); // for a transfer an interrupt handler started after the first wait
+	fillData = val * 0x01010101u;
+
+	channel.src = const_cast<unsigned*>(&fillData);
+	channel.dest = d;
+	channel.control = DMAChannel::ENABLE | DMAChannel::WORDS | DMAChannel::SRC_FIXED | size / 4;
+}
+
+bool DMA::IsBusy()
+{
+	return GetChannel().control & DMAChannel::ENABLE;
+}
+
+void DMA::Wait()
+{
+	while (IsBusy()) {}
+
+	asm volatile("" ::: "memory");
+}
@@ -1,11 +1,170 @@
 #include "SM64DS_PI.h"
 
-static void CopyBackwards(char* dest, const char* src, size_t size)
+#ifdef ARM9
+#include "../source/dma.h"
+#endif
+
+// Small copies, the unaligned head and the tail are done with bit tests instead of
+// loops, because GCC could otherwise turn byte loops back into calls to memcpy.
+
+using Word [[gnu::may_alias]] = unsigned;
+
+[[gnu::always_inline]]
+static inline void CopyBytesForward(char*& dest, const char*& src, size_t size)
+{
+	if (size & 4) { *dest++ = *src++; *dest++ = *src++; *dest++ = *src++; *dest++ = *src++; }
+	if (size & 2) { *dest++ = *src++; *dest++ = *src++; }
+	if (size & 1) { *dest++ = *src++; }
+}
+
+[[gnu::always_inline]]
+static inline void CopyBytesBackward(char*& dest, const char*& src, size_t size)
+{
+	if (size & 4) { *--dest = *--src; *--dest = *--src; *--dest = *--src; *--dest = *--src; }
+	if (size & 2) { *--dest = *--src; *--dest = *--src; }
+	if (size & 1) { *--dest = *--src; }
+}
+
+// Copies 32 bytes at a time until less than 32 bytes are left
+[[gnu::always_inline]]
+static inline void CopyBlocksForward(Word*& dest, const Word*& src, size_t& size)
+{
+#ifdef ARM9
+	asm volatile(R"(
+	subs  %2, %2, #32
+	blo   2f
+1:	ldmia %1!, {r3-r10}
+	stmia %0!, {r3-r10}
+	subs  %2, %2, #32
+	bhs   1b
+2:	add   %2, %2, #32
+)"
+	: "+r" (dest), "+r" (src), "+r" (size)
+	:: "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "cc", "memory");
+#else
+	for (; size >= 32; size -= 32, dest += 8, src += 8)
+		for (int i = 0; i < 8; i++) dest[i] = src[i];
+#endif
+}
+
+[[gnu::always_inline]]
+static inline void CopyBlocksBackward(Word*& dest, const Word*& src, size_t& size)
+{
+#ifdef ARM9
+	asm volatile(R"(
+	subs  %2, %2, #32
+	blo   2f
+1:	ldmdb %1!, {r3-r10}
+	stmdb %0!, {r3-r10}
+	subs  %2, %2, #32
+	bhs   1b
+2:	add   %2, %2, #32
+)"
+	: "+r" (dest), "+r" (src), "+r" (size)
+	:: "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "cc", "memory");
+#else
+	for (; size >= 32; size -= 32)
+		for (int i = 0; i < 8; i++) *--dest = *--src;
+#endif
+}
+
+[[gnu::always_inline]]
+static inline void CopyForward(char* dest, const char* src, size_t size)
+{
+	if (size < 8)
+		return CopyBytesForward(dest, src, size);
+
+	const size_t head = -reinterpret_cast<uintptr_t>(dest) & 3;
+
+	if (head & 1) { *dest++ = *src++; }
+	if (head & 2) { *dest++ = *src++; *dest++ = *src++; }
+
+	size -= head;
+
+	Word* d = reinterpret_cast<Word*>(dest);
+
+	if (const unsigned misalignment = reinterpret_cast<uintptr_t>(src) & 3)
+	{
+		// Build each destination word from two source words
+		const unsigned shift = misalignment * 8;
+		const Word* s = reinterpret_cast<const Word*>(src - misalignment);
+
+		for (Word prev = *s++; size >= 4; size -= 4)
+		{
+			const Word next = *s++;
+			*d++ = prev >> shift | next << (32 - shift);
+			prev = next;
+		}
+
+		src = reinterpret_cast<const char*>(s) - 4 + misalignment;
+	}
+	else
+	{
+		const Word* s = reinterpret_cast<const Word*>(src);
+
+		CopyBlocksForward(d, s, size);
+
+		if (size & 16) { d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3]; d += 4; s += 4; }
+		if (size & 8)  { d[0] = s[0]; d[1] = s[1]; d += 2; s += 2; }
+		if (size & 4)  { *d++ = *s++; }
+
+		src = reinterpret_cast<const char*>(s);
+	}
+
+	dest = reinterpret_cast<char*>(d);
+
+	CopyBytesForward(dest, src, size & 3);
+}
+
+// Copies from the end to the beginning, which is safe when the destination overlaps the end of the source
+[[gnu::always_inline]]
+static inline void CopyBackward(char* dest, const char* src, size_t size)
 {
 	dest += size;
 	src += size;
 
-	while (size--) *--dest = *--src;
+	if (size < 8)
+		return CopyBytesBackward(dest, src, size);
+
+	const size_t head = reinterpret_cast<uintptr_t>(dest) & 3;
+
+	if (head & 1) { *--dest = *--src; }
+	if (head & 2) { *--dest = *--src; *--dest = *--src; }
+
+	size -= head;
+
+	Word* d = reinterpret_cast<Word*>(dest);
+
+	if (const unsigned misalignment = reinterpret_cast<uintptr_t>(src) & 3)
+	{
+		const unsigned shift = misalignment * 8;
+		const Word* s = reinterpret_cast<const Word*>(src - misalignment);
+
+		for (Word next = *s; size >= 4; size -= 4)
+		{
+			const Word prev = *--s;
+			*--d = prev >> shift | next << (32 - shift);
+			next = prev;
+		}
+
+		src = reinterpret_cast<const char*>(s) + misalignment;
+	}
+	else
+	{
+		const Word* s = reinterpret_cast<const Word*>(src);
+
+		CopyBlocksBackward(d, s, size);
+
+		if (size & 16) { d[-1] = s[-1]; d[-2] = s[-2]; d[-3] = s[-3]; d[-4] = s[-4]; d -= 4; s -= 4; }
+		if (size & 8)  { d[-1] = s[-1]; d[-2] = s[-2]; d -= 2; s -= 2; }
+		if (size & 4)  { *--d = *--s; }
+
+		src = reinterpret_cast<const char*>(s);
+	}
+
+	dest = reinterpret_cast<char*>(d);
+
+	CopyBytesBackward(dest, src, size & 3);
 }
 
 extern "C"
@@ -17,9 +176,9 @@ extern "C"
 		const char* s = static_cast<const char*>(src);
 
 		if (d < s || d >= s + size)
-			CpuCopy8(src, dest, size);
+			CopyForward(d, s, size);
 		else if (d > s)
-			CopyBackwards(d, s, size);
+			CopyBackward(d, s, size);
 
 		return dest;
 	}
@@ -27,7 +186,15 @@ extern "C"
 	[[gnu::section(".memcpy")]]
 	void* memcpy(void* dest, const void* src, size_t size)
 	{
-		CpuCopy8(src, dest, size);
+#ifdef ARM9
+		if (size >= DMA::minSize && DMA::CanCopy(dest, src, size))
+		{
+			DMA::Copy(dest, src, size);
+
+			return dest;
+		}
+#endif
+		CopyForward(static_cast<char*>(dest), static_cast<const char*>(src), size);
 
 		return dest;
 	}
@@ -35,7 +202,70 @@ extern "C"
 	[[gnu::section(".memset")]]
 	void* memset(void* dest, int val, size_t size)
 	{
-		CpuFill8(dest, val, size);
+#ifdef ARM9
+		if (size >= DMA::minSize && DMA::CanFill(dest, size))
+		{
+			DMA::Fill(dest, val, size);
+
+			return dest;
+		}
+#endif
+
+		char* d = static_cast<char*>(dest);
+		const char c = val;
+
+		if (size < 8)
+		{
+			if (size & 4) { *d++ = c; *d++ = c; *d++ = c; *d++ = c; }
+			if (size & 2) { *d++ = c; *d++ = c; }
+			if (size & 1) { *d++ = c; }
+
+			return dest;
+		}
+
+		const size_t head = -reinterpret_cast<uintptr_t>(d) & 3;
+
+		if (head & 1) { *d++ = c; }
+		if (head & 2) { *d++ = c; *d++ = c; }
+
+		size -= head;
+
+		Word* w = reinterpret_cast<Word*>(d);
+		const Word fill = (val & 0xff) * 0x01010101u;
+
+#ifdef ARM9
+		asm volatile(R"(
+		subs  %1, %1, #32
+		blo   2f
+		mov   r3, %2
+		mov   r4, %2
+		mov   r5, %2
+		mov   r6, %2
+		mov   r7, %2
+		mov   r8, %2
+		mov   r9, %2
+		mov   r10, %2
+1:		stmia %0!, {r3-r10}
+		subs  %1, %1, #32
+		bhs   1b
+2:		add   %1, %1, #32
+)"
+		: "+r" (w), "+r" (size)
+		: "r" (fill)
+		: "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "cc", "memory");
+#else
+		for (; size >= 32; size -= 32)
+			for (int i = 0; i < 8; i++) *w++ = fill;
+#endif
+
+		if (size & 16) { w[0] = fill; w[1] = fill; w[2] = fill; w[3] = fill; w += 4; }
+		if (size & 8)  { w[0] = fill; w[1] = fill; w += 2; }
+		if (size & 4)  { *w++ = fill; }
+
+		d = reinterpret_cast<char*>(w);
+
+		if (size & 2) { *d++ = c; *d++ = c; }
+		if (size & 1) { *d++ = c; }
 
 		return dest;
 	}
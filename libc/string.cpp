@@ -0,0 +1,157 @@
+#include "SM64DS_PI.h"
+
+// Whole aligned words are read even past the end of a string, which is
+// safe because an aligned word never crosses a protection region boundary.
+
+using Word [[gnu::may_alias]] = unsigned;
+
+[[gnu::always_inline]]
+static inline bool HasZeroByte(Word w)
+{
+	return (w - 0x01010101u) & ~w & 0x80808080u;
+}
+
+[[gnu::always_inline]]
+static inline bool IsAligned(const void* ptr)
+{
+	return (reinterpret_cast<uintptr_t>(ptr) & 3) == 0;
+}
+
+[[gnu::always_inline]]
+static inline bool HaveSameAlignment(const void* a, const void* b)
+{
+	return ((reinterpret_cast<uintptr_t>(a) ^ reinterpret_cast<uintptr_t>(b)) & 3) == 0;
+}
+
+extern "C"
+{
+	void* memset(void* dest, int val, size_t size);
+
+	[[gnu::section(".strlen")]]
+	size_t strlen(const char* str)
+	{
+		const char* s = str;
+
+		for (; !IsAligned(s); s++)
+			if (*s == 0) return s - str;
+
+		const Word* w = reinterpret_cast<const Word*>(s);
+
+		while (!HasZeroByte(*w)) w++;
+
+		for (s = reinterpret_cast<const char*>(w); *s != 0; s++);
+
+		return s - str;
+	}
+
+	[[gnu::section(".strcmp")]]
+	int strcmp(const char* str1, const char* str2)
+	{
+		const uint8_t* a = reinterpret_cast<const uint8_t*>(str1);
+		const uint8_t* b = reinterpret_cast<const uint8_t*>(str2);
+
+		if (HaveSameAlignment(a, b))
+		{
+			for (; !IsAligned(a); a++, b++)
+				if (*a != *b || *a == 0) return *a - *b;
+
+			const Word* wa = reinterpret_cast<const Word*>(a);
+			const Word* wb = reinterpret_cast<const Word*>(b);
+
+			while (*wa == *wb && !HasZeroByte(*wa)) wa++, wb++;
+
+			a = reinterpret_cast<const uint8_t*>(wa);
+			b = reinterpret_cast<const uint8_t*>(wb);
+		}
+
+		while (*a == *b && *a != 0) a++, b++;
+
+		return *a - *b;
+	}
+
+	[[gnu::section(".strncpy")]]
+	char* strncpy(char* dest, const char* src, size_t size)
+	{
+		char* d = dest;
+
+		if (HaveSameAlignment(d, src))
+		{
+			for (; !IsAligned(d) && size != 0; size--)
+			{
+				if ((*d++ = *src++) == 0)
+				{
+					memset(d, 0, size - 1);
+					return dest;
+				}
+			}
+
+			Word* wd = reinterpret_cast<Word*>(d);
+			const Word* ws = reinterpret_cast<const Word*>(src);
+
+			for (; size >= 4 && !HasZeroByte(*ws); size -= 4)
+				*wd++ = *ws++;
+
+			d = reinterpret_cast<char*>(wd);
+			src = reinterpret_cast<const char*>(ws);
+		}
+
+		for (; size != 0; size--)
+		{
+			if ((*d++ = *src++) == 0)
+			{
+				memset(d, 0, size - 1);
+				break;
+			}
+		}
+
+		return dest;
+	}
+
+	[[gnu::section(".memcmp")]]
+	int memcmp(const void* ptr1, const void* ptr2, size_t size)
+	{
+		const uint8_t* a = static_cast<const uint8_t*>(ptr1);
+		const uint8_t* b = static_cast<const uint8_t*>(ptr2);
+
+		if (size >= 8 && HaveSameAlignment(a, b))
+		{
+			for (; !IsAligned(a); a++, b++, size--)
+				if (*a != *b) return *a - *b;
+
+			const Word* wa = reinterpret_cast<const Word*>(a);
+			const Word* wb = reinterpret_cast<const Word*>(b);
+
+			for (; size >= 4 && *wa == *wb; size -= 4)
+				wa++, wb++;
+
+			a = reinterpret_cast<const uint8_t*>(wa);
+			b = reinterpret_cast<const uint8_t*>(wb);
+		}
+
+		for (; size != 0; a++, b++, size--)
+			if (*a != *b) return *a - *b;
+
+		return 0;
+	}
+
+	[[gnu::section(".memchr")]]
+	void* memchr(const void* ptr, int val, size_t size)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(ptr);
+		const uint8_t c = val;
+
+		for (; !IsAligned(p) && size != 0; p++, size--)
+			if (*p == c) return const_cast<uint8_t*>(p);
+
+		const Word* w = reinterpret_cast<const Word*>(p);
+		const Word pattern = c * 0x01010101u;
+
+		for (; size >= 4 && !HasZeroByte(*w ^ pattern); size -= 4)
+			w++;
+
+		for (p = reinterpret_cast<const uint8_t*>(w); size != 0; p++, size--)
+			if (*p == c) return const_cast<uint8_t*>(p);
+
+		return nullptr;
+	}
+}
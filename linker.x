@@ -4,6 +4,8 @@ SECTIONS {
 	.text : {
 		KEEP(*(.text))
 		KEEP(*(.text.*))
+		*(.memcpy .memmove .memset .memcmp .memchr .strlen .strcmp .strncpy)
+		*(.glue_7 .glue_7t .vfp11_veneer .v4_bx)
 
 		KEEP(*(.data))
 		KEEP(*(.data.*))
@@ -17,4 +19,17 @@ SECTIONS {
 		KEEP(*(COMMON))
 		KEEP(*(COMMON.*))
 	}
+
+	/* Runs from the free part of ITCM, but is stored after .text until
+	   ITCM::Init copies it there (see source/itcm.h) */
+	.itcm 0x01ffdf40 : AT(ALIGN(LOADADDR(.text) + SIZEOF(.text), 4))
+	{
+		__itcm_start = .;
+		KEEP(*(.itcm.hook))
+		*(.itcm)
+		__itcm_end = .;
+	}
+
+	__itcm_load = LOADADDR(.itcm);
+	ASSERT(__itcm_end <= 0x02000000, "the functions marked ITCM_CODE don't fit into ITCM")
 }
@@ -1,4 +1,7 @@
+#include "actor_extension.h"
 #include "actor_tree.h"
+#include "warp_pipe_table.h"
+#include "frame_profiler.h"
 
 static_assert(alignof(ActorTreeNode) == alignof(Actor));
 static constinit std::byte* newExtensionAddr;
@@ -28,10 +31,25 @@ nsub_0201162c = _Z18ConstructExtensionR5Actor
 Actor& ConstructExtension(Actor& actor)
 {
 	new (newExtensionAddr) ActorTreeNode(actor);
+	WarpPipeTable::OnActorConstructed(actor);
 
 	return actor;
 }
 
+// uniqueIDs only grow, so the actors that were spawned since
+// the last call are the ones whose ID is greater than this
+static constinit unsigned lastFinishedID = 0;
+
+void FinishActorConstruction()
+{
+	ActorTreeNode::ForEachNewerThan(lastFinishedID, [](Actor& actor)
+	{
+		FrameProfiler::OnActorConstructed(actor);
+
+		lastFinishedID = actor.uniqueID;
+	});
+}
+
 asm(R"(
 repl_020112cc:
 repl_02011318:
@@ -54,5 +72,6 @@ static ActorTreeNode& GetTreeNode(const Actor& actor)
 
 void DestructExtension(const Actor& actor)
 {
+	WarpPipeTable::OnActorDestructed(actor);
 	GetTreeNode(actor).~ActorTreeNode();
 }
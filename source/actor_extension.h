@@ -17,4 +17,10 @@ struct ActorExtension
 
 ActorExtension* GetActorExtension(const Actor& actor);
 
+// Called once per frame by frame_hook.cpp. ConstructExtension runs at the end of
+// the constructor of Actor, when the vptr still points to the vtable of Actor,
+// so the modules that patch the vtable of each class are told about new actors
+// here instead, once their constructors have returned.
+void FinishActorConstruction();
+
 #endif
\ No newline at end of file
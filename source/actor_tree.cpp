@@ -1,4 +1,5 @@
 #include "actor_tree.h"
+#include "itcm.h"
 #include <ranges>
 
 using Node = ActorTreeNode;
@@ -121,7 +122,7 @@ void Node::RestoreBalance(Node*& node)
 	}
 }
 
-Actor* Node::Find(unsigned uniqueID)
+ITCM_HOOK Actor* Node::Find(unsigned uniqueID)
 {
 	Node* node = root;
 
@@ -56,6 +56,20 @@ class ActorTreeNode
 	static void Remove(ActorTreeNode*& root, unsigned uniqueID);
 	static void RestoreBalance(ActorTreeNode*& node);	
 
+	template<class F>
+	static void ForEachNewerThan(ActorTreeNode* node, unsigned uniqueID, F& func)
+	{
+		if (!node) return;
+
+		if (node->uniqueID > uniqueID)
+		{
+			ForEachNewerThan(node->left, uniqueID, func);
+			func(node->actor);
+		}
+
+		ForEachNewerThan(node->right, uniqueID, func);
+	}
+
 	static ActorTreeNode* root;
 
 public:
@@ -66,6 +80,13 @@ public:
 
 	static Actor* Find(unsigned uniqueID);
 
+	// Calls func for each actor with a greater uniqueID, in the order they were spawned
+	template<class F>
+	static void ForEachNewerThan(unsigned uniqueID, F&& func)
+	{
+		ForEachNewerThan(root, uniqueID, func);
+	}
+
 	      Actor& GetActor()       { return actor; }
 	const Actor& GetActor() const { return actor; }
 };
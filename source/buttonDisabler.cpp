@@ -2,7 +2,8 @@
 
 uint16_t realButtonsPressed, realButtonsHeld;
 
-void hook_0202bbe4()
+// Called once per frame from frame_hook.cpp, after the input was read
+void DisableButtons()
 {
 	realButtonsPressed = INPUT_ARR[0].buttonsPressed;
 	realButtonsHeld = INPUT_ARR[0].buttonsHeld;
@@ -0,0 +1,107 @@
+#ifndef CLSN_MATH_INCLUDED
+#define CLSN_MATH_INCLUDED
+
+#include "SM64DS_PI.h"
+#include <utility>
+
+// Fixed-point helpers for colliders that compute collision from a shape
+namespace ClsnMath
+{
+	// Squares of raw values have 24 fractional bits and don't overflow
+	// like the squares of Fix12i do for values above 724
+	using Square = int64_t;
+
+	inline Square Sq(Fix12i x)
+	{
+		return static_cast<int64_t>(x.val) * x.val;
+	}
+
+	inline Fix12i RootOf(Square x)
+	{
+		if (x <= 0) return 0_f;
+
+		uint64_t rem = x;
+		uint64_t res = 0;
+		uint64_t bit = 1ull << 62;
+
+		while (bit > rem) bit >>= 2;
+
+		for (; bit != 0; bit >>= 2)
+		{
+			if (rem >= res + bit)
+			{
+				rem -= res + bit;
+				res = (res >> 1) + bit;
+			}
+			else
+				res >>= 1;
+		}
+
+		return Fix12i(static_cast<int>(res), as_raw);
+	}
+
+	inline Fix12i FromInt(int val)
+	{
+		return Fix12i(val << 12, as_raw);
+	}
+
+	inline Vector3 Up()
+	{
+		return {0_f, 1._f, 0_f};
+	}
+
+	inline Vector3 Scaled(const Vector3& v, Fix12i s)
+	{
+		return {v.x * s, v.y * s, v.z * s};
+	}
+
+	inline Vector3 PointOnLine(const Vector3& pos0, const Vector3& v, Fix12i t)
+	{
+		return {pos0.x + v.x * t, pos0.y + v.y * t, pos0.z + v.z * t};
+	}
+
+	inline Fix12i Clamp(Fix12i val, Fix12i min, Fix12i max)
+	{
+		return val < min ? min : val > max ? max : val;
+	}
+
+	// Clips the line pos0 + t * v to min <= pos0 + t * v <= max, where tEnter <= t <= tExit
+	inline bool ClipLine(Fix12i pos0, Fix12i v, Fix12i min, Fix12i max, Fix12i& tEnter, Fix12i& tExit)
+	{
+		if (Abs(v) < 1._f)
+			return min <= pos0 && pos0 <= max;
+
+		Fix12i t0 = (min - pos0) / v;
+		Fix12i t1 = (max - pos0) / v;
+
+		if (t0 > t1) std::swap(t0, t1);
+
+		if (t0 > tEnter) tEnter = t0;
+		if (t1 < tExit)  tExit = t1;
+
+		return tEnter <= tExit;
+	}
+
+	// Merges the pushback of one surface with the ones of the others, like the mesh colliders do
+	inline void AddPushback(SphereClsn& sphere, const Vector3& pushback)
+	{
+		if (sphere.pushback0.x > pushback.x) sphere.pushback0.x = pushback.x;
+		if (sphere.pushback0.y > pushback.y) sphere.pushback0.y = pushback.y;
+		if (sphere.pushback0.z > pushback.z) sphere.pushback0.z = pushback.z;
+
+		if (sphere.pushback1.x < pushback.x) sphere.pushback1.x = pushback.x;
+		if (sphere.pushback1.y < pushback.y) sphere.pushback1.y = pushback.y;
+		if (sphere.pushback1.z < pushback.z) sphere.pushback1.z = pushback.z;
+	}
+
+	inline Vector3 Normalized(const Vector3& v)
+	{
+		const Fix12i length = RootOf(Sq(v.x) + Sq(v.y) + Sq(v.z));
+
+		if (length == 0_f) return Up();
+
+		return {v.x / length, v.y / length, v.z / length};
+	}
+}
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef COLLIDER_GRID_INCLUDED
+#define COLLIDER_GRID_INCLUDED
+
+#include "SM64DS_PI.h"
+#include <array>
+#include <bit>
+#include <new>
+
+// A broad phase for mesh colliders. The game tests every enabled collider in every
+// collision query, so instead of enabling each collider, colliders are added to a grid
+// of cells along X and Z, and a single enabled collider passes each query on to the
+// colliders whose bounds overlap it.
+//
+// Ground queries of colliders that implement ColliderGrid::FloorShape are cached by
+// position until a collider whose bounds contain the position is added, moved or removed,
+// so repeated queries at the same spot, like those of actors that stand still and their
+// shadows, are a hash probe, even while a platform moves elsewhere in the level.
+//
+// Everything is defined in this header, because DLs can't call functions of the main
+// binary, so each DL that includes it has its own grid.
+
+struct AABB
+{
+	Vector3 min;
+	Vector3 max;
+
+	bool Overlaps(const AABB& other) const
+	{
+		return min.x <= other.max.x && other.min.x <= max.x
+			&& min.y <= other.max.y && other.min.y <= max.y
+			&& min.z <= other.max.z && other.min.z <= max.z;
+	}
+};
+
+namespace ColliderGrid
+{
+	using Mask = uint64_t;
+
+	constexpr unsigned maxColliders = 64; // one bit of a Mask each
+	constexpr unsigned cellShift = 10 + 12; // 1024 units, in raw Fix12i
+	constexpr unsigned bucketBits = 6;
+	constexpr unsigned maxCellsPerRange = 16;
+	constexpr unsigned triangleBits = 9; // below the ID of the entry, which takes the other 6 bits of a positive short
+	constexpr unsigned maxTriangleID = (1 << triangleBits) - 1;
+	constexpr unsigned cacheBits = 4;
+	constexpr unsigned maxCachedFloors = 4;
+	constexpr Fix12i margin = 1._f; // for the tolerance of the colliders on the edges of their shapes
+
+	// For colliders with at most one floor at each XZ position. The floors are cached
+	// without the filter of the ray, which is applied to the CLPS of a floor when it's used.
+	struct FloorShape
+	{
+		// Returns false if there is no floor at the position
+		virtual bool FloorAt(Fix12i x, Fix12i z, Fix12i& y, Vector3& normal) const = 0;
+		virtual const CLPS& FloorCLPS() const = 0;
+
+		// Sets the result like DetectClsn, unless the ray already hit something higher
+		virtual bool SetGroundResult(RaycastGround& ray, Fix12i y, const Vector3& normal) = 0;
+	};
+
+	struct Entry
+	{
+		MeshColliderBase* collider;
+		FloorShape* floor;
+		AABB bounds;
+	};
+
+	struct CachedFloor
+	{
+		unsigned id;
+		Fix12i y;
+		Vector3 normal;
+	};
+
+	// The floors at a position, from the highest to the lowest
+	struct CachedColumn
+	{
+		bool isValid;
+		Fix12i x;
+		Fix12i z;
+		unsigned numFloors;
+		std::array<CachedFloor, maxCachedFloors> floors;
+	};
+
+	inline std::array<Entry, maxColliders> entries;
+	inline std::array<CachedColumn, 1 << cacheBits> cache;
+	inline constinit std::array<Mask, 1 << bucketBits> buckets = {};
+	inline constinit Mask usedMask = 0;
+	inline constinit Mask largeMask = 0; // colliders that cover too many cells to be put in buckets
+	inline constinit Mask floorMask = 0;
+
+	inline unsigned Hash(int x, int z, unsigned bits)
+	{
+		return (x * 0x9e3779b1u ^ z * 0x85ebca6bu) >> (32 - bits);
+	}
+
+	inline unsigned Bucket(int cellX, int cellZ)
+	{
+		return Hash(cellX, cellZ, bucketBits);
+	}
+
+	// Calls f with the bucket of each cell the bounds overlap, unless they overlap too many cells
+	inline bool ForEachBucket(const AABB& bounds, auto&& f)
+	{
+		const int minX = bounds.min.x.val >> cellShift;
+		const int maxX = bounds.max.x.val >> cellShift;
+		const int minZ = bounds.min.z.val >> cellShift;
+		const int maxZ = bounds.max.z.val >> cellShift;
+
+		if (static_cast<unsigned>((maxX - minX + 1) * (maxZ - minZ + 1)) > maxCellsPerRange)
+			return false;
+
+		for (int z = minZ; z <= maxZ; z++)
+			for (int x = minX; x <= maxX; x++)
+				f(Bucket(x, z));
+
+		return true;
+	}
+
+	// Outdates the cached columns that the bounds of the entry contain, which are the only
+	// ones its collider can be a candidate of
+	inline void InvalidateColumns(unsigned id)
+	{
+		const AABB& bounds = entries[id].bounds;
+
+		for (CachedColumn& column : cache)
+			if (bounds.min.x <= column.x && column.x <= bounds.max.x
+				&& bounds.min.z <= column.z && column.z <= bounds.max.z)
+				column.isValid = false;
+	}
+
+	inline void Insert(unsigned id, const AABB& bounds)
+	{
+		const Mask bit = Mask(1) << id;
+		const Vector3 padding = {margin, margin, margin};
+		AABB& padded = entries[id].bounds;
+
+		padded = {bounds.min - padding, bounds.max + padding};
+
+		if (!ForEachBucket(padded, [bit](unsigned bucket) { buckets[bucket] |= bit; }))
+			largeMask |= bit;
+
+		InvalidateColumns(id);
+	}
+
+	inline void Erase(unsigned id)
+	{
+		const Mask bit = Mask(1) << id;
+
+		InvalidateColumns(id);
+
+		for (Mask& bucket : buckets)
+			bucket &= ~bit;
+
+		largeMask &= ~bit;
+	}
+
+	inline int Find(const MeshColliderBase& collider)
+	{
+		for (Mask mask = usedMask; mask != 0; mask &= mask - 1)
+		{
+			const unsigned id = std::countr_zero(mask);
+
+			if (entries[id].collider == &collider)
+				return id;
+		}
+
+		return -1;
+	}
+
+	// The triangle ID of a collision found through the grid has the ID of the entry above
+	// the one the collider gave it, so that the surface info can be looked up in the
+	// collider that found it for as long as the result is kept. Colliders in the grid
+	// may only use the triangle IDs up to maxTriangleID.
+	inline short AddHit(unsigned id, short triangleID)
+	{
+		if (triangleID < 0 || triangleID > static_cast<short>(maxTriangleID)) Crash();
+
+		return id << triangleBits | triangleID;
+	}
+
+	// Returns nullptr if the collider has been removed since the collision was found.
+	// If another collider was added in its place, the result refers to that one.
+	inline MeshColliderBase* ColliderOfHit(short triangleID)
+	{
+		const unsigned id = triangleID >> triangleBits;
+
+		return usedMask >> id & 1 ? entries[id].collider : nullptr;
+	}
+
+	// Calls f with the ID of each collider in the mask whose bounds overlap the given ones
+	inline void ForEachCandidate(const AABB& bounds, Mask mask, auto&& f)
+	{
+		Mask candidates = largeMask;
+
+		if (!ForEachBucket(bounds, [&candidates](unsigned bucket) { candidates |= buckets[bucket]; }))
+			candidates = usedMask;
+
+		for (candidates &= mask; candidates != 0; candidates &= candidates - 1)
+		{
+			const unsigned id = std::countr_zero(candidates);
+
+			if (entries[id].bounds.Overlaps(bounds))
+				f(id);
+		}
+	}
+
+	inline AABB ColumnAt(Fix12i x, Fix12i z)
+	{
+		return {{x, Fix12i(INT32_MIN, as_raw), z}, {x, Fix12i(INT32_MAX, as_raw), z}};
+	}
+
+	// Returns nullptr if there are too many floors at the position to cache them
+	inline const CachedColumn* FloorsAt(Fix12i x, Fix12i z)
+	{
+		CachedColumn& column = cache[Hash(x.val, z.val, cacheBits)];
+
+		if (column.isValid && column.x == x && column.z == z)
+			return &column;
+
+		column.isValid = false;
+		column.x = x;
+		column.z = z;
+		column.numFloors = 0;
+
+		bool tooMany = false;
+
+		ForEachCandidate(ColumnAt(x, z), floorMask, [&](unsigned id)
+		{
+			CachedFloor floor = {id};
+
+			if (tooMany || !entries[id].floor->FloorAt(x, z, floor.y, floor.normal))
+				return;
+
+			if (column.numFloors == maxCachedFloors)
+			{
+				tooMany = true;
+				return;
+			}
+
+			unsigned i = column.numFloors++;
+
+			for (; i > 0 && column.floors[i - 1].y < floor.y; i--)
+				column.floors[i] = column.floors[i - 1];
+
+			column.floors[i] = floor;
+		});
+
+		if (tooMany) return nullptr;
+
+		column.isValid = true;
+
+		return &column;
+	}
+
+	inline bool DetectGround(unsigned id, RaycastGround& ray)
+	{
+		MeshColliderBase& collider = *entries[id].collider;
+
+		if (!collider.DetectClsn(ray)) return 0;
+
+		ray.result.triangleID = AddHit(id, ray.result.triangleID);
+		return 1;
+	}
+
+	inline bool DetectCachedGround(RaycastGround& ray)
+	{
+		const CachedColumn* column = FloorsAt(ray.pos.x, ray.pos.z);
+
+		if (!column)
+		{
+			bool res = 0;
+			ForEachCandidate(ColumnAt(ray.pos.x, ray.pos.z), floorMask, [&](unsigned id) { res |= DetectGround(id, ray); });
+
+			return res;
+		}
+
+		// The first floor below the ray that it doesn't pass through is the highest one
+		for (unsigned i = 0; i < column->numFloors; i++)
+		{
+			const CachedFloor& floor = column->floors[i];
+			const Entry& entry = entries[floor.id];
+
+			if (floor.y > ray.pos.y) continue;
+			if (ray.ShouldPassThrough(entry.floor->FloorCLPS(), false)) continue;
+
+			if (!entry.floor->SetGroundResult(ray, floor.y, floor.normal)) return 0;
+
+			ray.result.triangleID = AddHit(floor.id, ray.result.triangleID);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	struct Proxy : public MeshColliderBase
+	{
+		// Results of removed colliders get a flat floor with the default CLPS at the origin
+		virtual void GetSurfaceInfo(short triangleID, SurfaceInfo& res) final override
+		{
+			if (MeshColliderBase* collider = ColliderOfHit(triangleID))
+				collider->GetSurfaceInfo(triangleID & maxTriangleID, res);
+			else
+			{
+				res.clps = {};
+				res.normal = {0_f, 1._f, 0_f};
+			}
+		}
+
+		virtual void GetNormal(short triangleID, Vector3& res) final override
+		{
+			if (MeshColliderBase* collider = ColliderOfHit(triangleID))
+				collider->GetNormal(triangleID & maxTriangleID, res);
+			else
+				res = {0_f, 1._f, 0_f};
+		}
+
+		virtual void GetTriangleOrigin(short triangleID, Vector3& res) final override
+		{
+			if (MeshColliderBase* collider = ColliderOfHit(triangleID))
+				collider->GetTriangleOrigin(triangleID & maxTriangleID, res);
+			else
+				res = {0_f, 0_f, 0_f};
+		}
+
+		virtual bool DetectClsn(RaycastGround& ray) final override
+		{
+			const AABB bounds = {{ray.pos.x, Fix12i(INT32_MIN, as_raw), ray.pos.z}, ray.pos};
+			bool res = 0;
+
+			ForEachCandidate(bounds, ~floorMask, [&](unsigned id) { res |= DetectGround(id, ray); });
+
+			if (floorMask != 0)
+				res |= DetectCachedGround(ray);
+
+			return res;
+		}
+
+		virtual bool DetectClsn(RaycastLine& ray) final override
+		{
+			const Vector3& pos0 = ray.line.pos0;
+			const Vector3& pos1 = ray.line.pos1;
+
+			const AABB bounds =
+			{
+				{pos0.x < pos1.x ? pos0.x : pos1.x, pos0.y < pos1.y ? pos0.y : pos1.y, pos0.z < pos1.z ? pos0.z : pos1.z},
+				{pos0.x < pos1.x ? pos1.x : pos0.x, pos0.y < pos1.y ? pos1.y : pos0.y, pos0.z < pos1.z ? pos1.z : pos0.z}
+			};
+
+			bool res = 0;
+
+			ForEachCandidate(bounds, usedMask, [&](unsigned id)
+			{
+				MeshColliderBase& collider = *entries[id].collider;
+
+				if (collider.DetectClsn(ray))
+				{
+					ray.result.triangleID = AddHit(id, ray.result.triangleID);
+					res = 1;
+				}
+			});
+
+			return res;
+		}
+
+		virtual unsigned DetectClsn(SphereClsn& sphere) final override
+		{
+			const Vector3 radius = {sphere.radius, sphere.radius, sphere.radius};
+			const AABB bounds = {sphere.pos - radius, sphere.pos + radius};
+
+			unsigned res = 0;
+
+			ForEachCandidate(bounds, usedMask, [&](unsigned id)
+			{
+				MeshColliderBase& collider = *entries[id].collider;
+
+				// Colliders only set the floor result if they are a floor
+				const short oldFloorID = sphere.floorResult.triangleID;
+				sphere.floorResult.triangleID = -1;
+
+				if (collider.DetectClsn(sphere))
+				{
+					sphere.result.triangleID = AddHit(id, sphere.result.triangleID);
+					res = 1;
+				}
+
+				if (sphere.floorResult.triangleID == -1)
+					sphere.floorResult.triangleID = oldFloorID;
+				else
+					sphere.floorResult.triangleID = AddHit(id, sphere.floorResult.triangleID);
+			});
+
+			return res;
+		}
+	};
+
+	alignas(Proxy) inline constinit std::byte proxyStorage[sizeof(Proxy)] = {};
+	inline constinit Proxy* proxy = nullptr;
+
+	// Returns false if the grid is full, in which case the collider has to be enabled on its own
+	inline bool Add(MeshColliderBase& collider, const AABB& bounds, FloorShape* floor = nullptr)
+	{
+		if (usedMask == ~Mask(0)) return false;
+
+		if (!proxy)
+			proxy = new (proxyStorage) Proxy;
+
+		if (usedMask == 0)
+			proxy->Enable();
+
+		const unsigned id = std::countr_one(usedMask);
+
+		usedMask |= Mask(1) << id;
+		entries[id].collider = &collider;
+		entries[id].floor = floor;
+		Insert(id, bounds);
+
+		if (floor)
+			floorMask |= Mask(1) << id;
+
+		return true;
+	}
+
+	// For colliders that move or change their size
+	inline void Move(const MeshColliderBase& collider, const AABB& bounds)
+	{
+		if (const int id = Find(collider); id >= 0)
+		{
+			Erase(id);
+			Insert(id, bounds);
+		}
+	}
+
+	// Returns false if the collider wasn't in the grid
+	inline bool Remove(const MeshColliderBase& collider)
+	{
+		const int id = Find(collider);
+
+		if (id < 0) return false;
+
+		Erase(id);
+		usedMask &= ~(Mask(1) << id);
+		floorMask &= ~(Mask(1) << id);
+
+		if (usedMask == 0)
+			proxy->Disable();
+
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef DMA_INCLUDED
+#define DMA_INCLUDED
+
+#include "SM64DS_PI.h"
+
+// Copies and fills main RAM with a DMA channel. The parts of the destination that
+// share a cache line with other data are handled by the CPU before the transfer
+// starts, so the CPU can keep working on anything but the source and destination
+// until the transfer is finished.
+namespace DMA
+{
+	// The NitroSDK libraries in the game only use the DMA channels they're given:
+	// GX, for the geometry FIFO and VRAM transfers, uses GX_DEFAULT_DMAID, which
+	// is 3, and the card and file system use the one passed to FS_Init. The game's
+	// own code doesn't program the channels directly, so channel 1 is left free.
+	// When porting this, check it with a write watchpoint on 0x040000bc-0x040000c7.
+	constexpr unsigned channel = 1;
+	constexpr size_t minSize = 0x800; // memcpy and memset use DMA for transfers at least this big
+
+	// Both buffers need to be in main RAM outside of DTCM, and the
+	// source and destination need to have the same alignment modulo 4
+	bool CanCopy(const void* dest, const void* src, size_t size);
+	bool CanFill(const void* dest, size_t size);
+
+	// Start a transfer without waiting for it to finish. If the previous
+	// transfer is still running, these wait for it first. They can also be
+	// used by interrupt handlers.
+	void StartCopy(void* dest, const void* src, size_t size);
+	void StartFill(void* dest, uint8_t val, size_t size);
+
+	bool IsBusy();
+	void Wait();
+
+	inline void Copy(void* dest, const void* src, size_t size)
+	{
+		StartCopy(dest, src, size);
+		Wait();
+	}
+
+	inline void Fill(void* dest, uint8_t val, size_t size)
+	{
+		StartFill(dest, val, size);
+		Wait();
+	}
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include "extended_ks.h"
+#include "frame_profiler.h"
+#include "hw_timer.h"
+#include "itcm.h"
 #include "SM64DS_PI.h"
 
 namespace KuppaScriptImpl
@@ -6,11 +9,21 @@ namespace KuppaScriptImpl
 	using ESC = ExtendedScriptCompiler<>;
 
 	template<class... Args>
-	using PendingInstruction = ESC::PendingInstruction<(sizeof(Args) + ... + 1)>;
+	constexpr std::size_t paramBlockSize = 0;
+
+	template<class... Args> requires (sizeof...(Args) > 0)
+	constexpr std::size_t paramBlockSize<Args...> = GetParamsOffset(0) - 7 +
+		ParamSchema<std::remove_cvref_t<Args>...>::size;
+
+	template<class... Args>
+	using PendingInstruction = ESC::PendingInstruction<paramBlockSize<Args...> + 1>;
 
 	template<class... Args>
 	using Overload = PendingInstruction<Args...>(ESC::*)(Args...);
 
+	template<class... Args>
+	ParamSchema<std::remove_cvref_t<Args>...> DeduceSchema(Overload<Args...>);
+
 	template<uint8_t id>
 	struct ObjByID {};
 
@@ -50,12 +63,39 @@ namespace KuppaScriptImpl
 		(ptmf);
 
 		using Type = ID<typename ObjByID<ids[0]>::Type, ids[1]>;
+		using Schema = decltype(DeduceSchema(ptmf));
 	};
 
 	template<auto ptmf>
 	using GetID = GetID_Impl<ptmf>::Type;
 
+	// The parameter schema of an instruction is deduced from the parameter list of its interface function
+	template<auto ptmf>
+	using GetSchema = GetID_Impl<ptmf>::Schema;
+
 	struct UnimplementedTag {};
+
+	// The parameters of the WaitUntil instruction that is holding the script, if any.
+	// WaitUntil holds the script by decrementing KS_FRAME_COUNTER, which cancels
+	// out the increment at the end of the frame: the counter is heldFrame - 1 for
+	// the rest of the frame the predicate returned false on, and heldFrame on the
+	// next ones. If it's anything else, the script was restarted or its counter
+	// was changed by other code, so the suspension is stale.
+	constinit const char* suspendedBy = nullptr;
+	constinit short heldFrame = 0;
+}
+
+// Reads instruction parameters using the layout selected by KS_ALIGNED_PARAMS
+template<UnalignedReadable... Types> [[gnu::always_inline, nodiscard]]
+inline auto ReadParams(const char* params)
+{
+	return UnalignedImpl::ReadLayout<KuppaScriptImpl::alignedParams, Types...>(params);
+}
+
+template<class F> [[gnu::always_inline]]
+inline decltype(auto) VisitParams(const char* params, F&& f)
+{
+	return UnalignedImpl::VisitLayout<KuppaScriptImpl::alignedParams>(params, std::forward<F>(f));
 }
 
 template<class ID>
@@ -73,6 +113,12 @@ Implementation<KuppaScriptImpl::ID<Obj, subID>>
 #define IMPLEMENT_OVERLOAD(functionName, ...) template<> auto \
 Implementation<KuppaScriptImpl::GetID<KuppaScriptImpl::Overload<__VA_ARGS__>{&KuppaScriptImpl::ESC::functionName}>>
 
+#define PARAMS(functionName) \
+KuppaScriptImpl::GetSchema<&KuppaScriptImpl::ESC::functionName>
+
+#define PARAMS_OVERLOAD(functionName, ...) \
+KuppaScriptImpl::GetSchema<KuppaScriptImpl::Overload<__VA_ARGS__>{&KuppaScriptImpl::ESC::functionName}>
+
 #include "extended_ks.impl"
 
 namespace KuppaScriptImpl
@@ -108,8 +154,21 @@ namespace KuppaScriptImpl
 			return customInstructionTable<Obj, firstSubID + 1, nops + 1>;
 	}();
 
+	[[gnu::always_inline]]
+	inline const char* GetParams(const char* instruction)
+	{
+		if constexpr (alignedParams)
+		{
+			const uintptr_t addr = reinterpret_cast<uintptr_t>(instruction + 7);
+
+			return std::assume_aligned<4>(reinterpret_cast<const char*>(addr + 3 & ~3));
+		}
+		else
+			return instruction + 7;
+	}
+
 	template<class Obj>
-	static void CallInstruction(Obj& obj, char* instruction, short minFrame, short maxFrame)
+	static void DispatchInstruction(Obj& obj, char* instruction, short minFrame, short maxFrame)
 	{
 		const unsigned vFuncID = instruction[6];
 
@@ -125,24 +184,119 @@ namespace KuppaScriptImpl
 		const auto& cFuncs = customInstructionTable<Obj>;
 
 		if (cFuncID < cFuncs.size())
-			cFuncs[cFuncID](obj, instruction + 7, minFrame, maxFrame);
+			cFuncs[cFuncID](obj, GetParams(instruction), minFrame, maxFrame);
 	}
+
+	struct ProfileEntry
+	{
+		uint64_t ticks = 0; // 32 bits would overflow after about two minutes of scripts
+		unsigned calls = 0;
+	};
+
+	template<class Obj>
+	constinit std::array<ProfileEntry, numVFuncs<Obj> + customInstructionTable<Obj>.size()> profile = {};
+
+	template<class Obj>
+	static void CallInstruction(Obj& obj, char* instruction, short minFrame, short maxFrame)
+	{
+		// Only the pending predicate is evaluated while the script is suspended
+		if (suspendedBy) [[unlikely]]
+		{
+			if (KS_FRAME_COUNTER != heldFrame && KS_FRAME_COUNTER != heldFrame - 1)
+				suspendedBy = nullptr;
+			else if (suspendedBy != GetParams(instruction))
+				return;
+		}
+
+		const FrameProfiler::Scope scope(FrameProfiler::SCRIPTS, obj.actorID);
+
+		if constexpr (profileInstructions)
+		{
+			HWTimer::Start();
+
+			const unsigned start = HWTimer::Read();
+			DispatchInstruction(obj, instruction, minFrame, maxFrame);
+			const unsigned ticks = HWTimer::Read() - start;
+
+			const unsigned subID = instruction[6];
+
+			if (subID < profile<Obj>.size())
+			{
+				profile<Obj>[subID].ticks += ticks;
+				profile<Obj>[subID].calls++;
+			}
+		}
+		else
+			DispatchInstruction(obj, instruction, minFrame, maxFrame);
+	}
+
+	void PrintProfile()
+	{
+#if KS_PROFILE
+		struct Row
+		{
+			const ProfileEntry* entry;
+			unsigned subID;
+			bool isCamera;
+		};
+
+		std::array<Row, profile<Player>.size() + profile<Camera>.size()> rows;
+		auto numRows = 0u;
+
+		for (auto i = 0u; i < profile<Player>.size(); i++)
+			if (profile<Player>[i].calls != 0)
+				rows[numRows++] = {&profile<Player>[i], i, false};
+
+		for (auto i = 0u; i < profile<Camera>.size(); i++)
+			if (profile<Camera>[i].calls != 0)
+				rows[numRows++] = {&profile<Camera>[i], i, true};
+
+		std::sort(rows.begin(), rows.begin() + numRows, [](const Row& a, const Row& b)
+		{
+			return a.entry->ticks > b.entry->ticks;
+		});
+
+		cout << "Kuppa Script profile (thousands of cycles, calls, cycles per call):\n";
+
+		for (auto i = 0u; i < numRows; i++)
+		{
+			const auto [entry, subID, isCamera] = rows[i];
+			const uint64_t cycles = entry->ticks * HWTimer::cyclesPerTick;
+
+			cout << (isCamera ? "cam " : "player ") << subID << ": "
+				<< static_cast<unsigned>(cycles / 1000) << ", " << entry->calls << ", "
+				<< static_cast<unsigned>(cycles / entry->calls) << "\n";
+		}
+
+		profile<Player> = {};
+		profile<Camera> = {};
+#endif
+	}
+}
+
+void OnKuppaScriptEnd()
+{
+	KuppaScriptImpl::suspendedBy = nullptr;
+
+	if constexpr (KuppaScriptImpl::profileInstructions)
+		KuppaScriptImpl::PrintProfile();
 }
 
 using KuppaScriptImpl::CallInstruction;
 
-int repl_0200e5f0(Player& player, char* instruction, short minFrame, short maxFrame)
+ITCM_HOOK int repl_0200e5f0(Player& player, char* instruction, short minFrame, short maxFrame)
 {
 	CallInstruction(player, instruction, minFrame, maxFrame);
 
 	return 1; // just in case 0200e5ac is called from an unknown location
 }
 
-void repl_0200ed4c(Camera& cam, char* instruction, short minFrame, short maxFrame)
+ITCM_HOOK void repl_0200ed4c(Camera& cam, char* instruction, short minFrame, short maxFrame)
 {
 	CallInstruction(cam, instruction, minFrame, maxFrame);
 }
 
+#ifdef ARM9
 asm(R"(
 @ Check if the camera exists before updating the script from RunKuppaScript
 repl_0200ef5c:
@@ -167,6 +321,9 @@ nsub_0200ed70:
 
 @ Undo ActivatePlayer for player 0 every time a cutscene ends
 nsub_0200e7b0:
+	push  {r0-r3, r12, r14}
+	bl    _Z16OnKuppaScriptEndv
+	pop   {r0-r3, r12, r14}
 	ldr   r0, =PLAYER_ARR
 	ldr   r0, [r0]
 	cmp   r0, #0
@@ -176,3 +333,4 @@ nsub_0200e7b0:
 	ldr   r0, =#0x020890a0
 	b     0x0200e7b4
 )");
+#endif
@@ -2,29 +2,128 @@
 #define EXTENDED_KS_INCLUDED
 
 #include <cstring>
+#include <algorithm>
+#include <bit>
 #include "Cutscene.h"
 #include "SM64DS_PI.h"
+#include "spawn_queue.h"
+#include "unaligned.h"
+
+// Set this to 1 to pad the parameters of custom instructions so that each of them
+// is aligned like a struct member and the parameter block starts at a word boundary.
+// This makes scripts incompatible with builds that use the vanilla-compatible
+// packed layout, so the main patch and all DLs must agree on it.
+#ifndef KS_ALIGNED_PARAMS
+#define KS_ALIGNED_PARAMS 0
+#endif
+
+// Set this to 1 to measure how many cycles each Kuppa Script instruction takes.
+// The totals are printed when a cutscene ends or when PrintInstructionProfile is
+// run. Only the main patch needs to be built with this.
+#ifndef KS_PROFILE
+#define KS_PROFILE 0
+#endif
 
 using Any = KuppaScriptImpl::CharID_Type<0xff>;
 
 namespace KuppaScriptImpl {
 
+constexpr bool alignedParams = KS_ALIGNED_PARAMS;
+constexpr bool profileInstructions = KS_PROFILE;
+
+// Prints the instruction profile collected so far and resets it
+void PrintProfile();
+
+// The offset of the parameters of a custom instruction that starts
+// at the given offset from the beginning of a word-aligned script
+consteval std::size_t GetParamsOffset(std::size_t instructionOffset)
+{
+	const std::size_t offset = instructionOffset + 7;
+
+	return alignedParams ? UnalignedImpl::AlignUp(offset, 4) : offset;
+}
+
+// Describes the parameters of a custom instruction. The same schema is used to
+// encode them in the script and to decode them in the implementation function.
+template<class... Types>
+struct ParamSchema
+{
+	static constexpr const auto& offsets = UnalignedImpl::layoutOffsets<alignedParams, Types...>;
+	static constexpr std::size_t size = UnalignedImpl::layoutSize<alignedParams, Types...>;
+
+	template<std::size_t i>
+	using Type = std::tuple_element_t<i, std::tuple<Types...>>;
+
+	static consteval auto Encode(const Types&... args)
+	{
+		std::array<uint8_t, size> res = {};
+		std::size_t i = 0;
+
+		(std::ranges::copy(std::bit_cast<std::array<uint8_t, sizeof(Types)>>(args), res.begin() + offsets[i++]), ...);
+
+		return res;
+	}
+
+	template<std::size_t i> [[gnu::always_inline, nodiscard]]
+	static auto Get(const char* params)
+	{
+		return UnalignedImpl::ReadAs<alignedParams, Type<i>>(params + offsets[i]);
+	}
+
+	[[gnu::always_inline, nodiscard]]
+	static auto Read(const char* params)
+	{
+		return UnalignedImpl::ReadLayout<alignedParams, Types...>(params);
+	}
+
+	[[gnu::always_inline]]
+	static decltype(auto) Visit(const char* params, auto&& f)
+	{
+		return UnalignedImpl::Visit<alignedParams, Types...>(params, f);
+	}
+};
+
 template<std::size_t scriptSize = 0, class... Initializers>
-class ExtendedScriptCompiler : public BaseScriptCompiler<ExtendedScriptCompiler, scriptSize, Initializers...>
+class ExtendedScriptCompiler;
+
+// With the aligned layout, scripts need to start at a word boundary
+template<std::size_t scriptSize, class... Initializers>
+class alignas(alignedParams ? 4 : alignof(BaseScriptCompiler<ExtendedScriptCompiler, scriptSize, Initializers...>))
+ExtendedScriptCompiler : public BaseScriptCompiler<ExtendedScriptCompiler, scriptSize, Initializers...>
 {
 	using Base = BaseScriptCompiler<ExtendedScriptCompiler, scriptSize, Initializers...>;
 
+	static constexpr std::size_t paramsOffset = GetParamsOffset(scriptSize);
+
+	template<class... Args>
+	static consteval auto EncodeParams(const Args&... args)
+	{
+		using Schema = ParamSchema<Args...>;
+		constexpr std::size_t padding = paramsOffset - (scriptSize + 7);
+
+		std::array<uint8_t, padding + Schema::size> res = {};
+		std::ranges::copy(Schema::Encode(args...), res.begin() + padding);
+
+		return res;
+	}
+
 public:
 	template<uint8_t subID, class... NewInitializers>
 	consteval auto CamInstruction(const auto&... args)
 	{
-		return static_cast<Base&>(*this).template CamInstruction<subID, NewInitializers...>(args...);
+		if constexpr (sizeof...(args) > 0)
+			return static_cast<Base&>(*this).template CamInstruction<subID, NewInitializers...>(EncodeParams(args...));
+		else
+			return static_cast<Base&>(*this).template CamInstruction<subID, NewInitializers...>(args...);
 	}
 
 	template<CharID Char, uint8_t subID, class... NewInitializers>
 	consteval auto PlayerInstruction(const auto&... args)
 	{
-		return static_cast<Base&>(*this).template PlayerInstruction<Char, subID, NewInitializers...>(args...);
+		if constexpr (sizeof...(args) > 0)
+			return static_cast<Base&>(*this).template PlayerInstruction<Char, subID, NewInitializers...>(EncodeParams(args...));
+		else
+			return static_cast<Base&>(*this).template PlayerInstruction<Char, subID, NewInitializers...>(args...);
 	}
 
 	template<class F, CharID Char = Any>
@@ -46,15 +145,51 @@ public:
 
 		using Initializer = decltype([](char* scriptStart)
 		{
-			char* addr = scriptStart + scriptSize + 7;
+			char* addr = scriptStart + paramsOffset;
 
 			std::memcpy(addr, &funcPtr, sizeof(funcPtr));
 		});
 
+		// Reserve space for the function pointer, which is written at runtime
 		if constexpr (paramIsPlayer)
-			return PlayerInstruction<Char, 14u, Initializer>(0);
+			return PlayerInstruction<Char, 14u, Initializer>(uintptr_t{});
 		else
-			return CamInstruction<39u, Initializer>(0);
+			return CamInstruction<39u, Initializer>(uintptr_t{});
+	}
+
+	// Not a static local of WaitUntil, which GCC only allows in a consteval function from version 13
+	template<class F>
+	static constexpr auto predicatePtr = +[](ActorBase& actor) [[gnu::flatten]]
+	{
+		if constexpr (std::is_invocable_r_v<bool, F>)               return static_cast<bool>(F{}());
+		else if constexpr (std::is_invocable_r_v<bool, F, Camera&>) return static_cast<bool>(F{}(static_cast<Camera&>(actor)));
+		else                                                        return static_cast<bool>(F{}(static_cast<Player&>(actor)));
+	};
+
+	// Keeps the script on the current frame until the predicate returns true.
+	// While waiting, no other player or camera instruction is run. Object, level
+	// and music instructions aren't held, and run again on every frame waited.
+	template<class F, CharID Char = Any>
+	consteval auto WaitUntil(F)
+	{
+		constexpr bool noParams      = std::is_invocable_r_v<bool, F>;
+		constexpr bool paramIsCam    = std::is_invocable_r_v<bool, F, Camera&>;
+		constexpr bool paramIsPlayer = std::is_invocable_r_v<bool, F, Player&>;
+
+		static_assert(paramIsCam + paramIsPlayer + noParams == 1);
+		static_assert(!paramIsPlayer || std::same_as<Char, Any>);
+
+		using Initializer = decltype([](char* scriptStart)
+		{
+			char* addr = scriptStart + paramsOffset;
+
+			std::memcpy(addr, &predicatePtr<F>, sizeof(predicatePtr<F>));
+		});
+
+		if constexpr (paramIsPlayer)
+			return PlayerInstruction<Char, 28u, Initializer>(uintptr_t{});
+		else
+			return CamInstruction<52u, Initializer>(uintptr_t{});
 	}
 
 	/* -------- -------- Custom player instructions -------- -------- */
@@ -215,6 +350,20 @@ public:
 	{
 		return CamInstruction<50>(zAngleDiff);
 	}
+
+	consteval auto PrintInstructionProfile()
+	{
+		return CamInstruction<51>();
+	}
+
+	// Queues the spawn in the spawn queue, so that the actors a script spawns at
+	// once are spread over a few frames. One actor is queued on each frame the
+	// instruction is run on.
+	consteval auto SpawnActor(uint16_t actorID, uint16_t param1, Vector3_16 pos, short angleY, int8_t areaID,
+		SpawnQueue::Priority priority = SpawnQueue::NORMAL)
+	{
+		return CamInstruction<53>(actorID, param1, pos, angleY, areaID, priority);
+	}
 };
 
 template<> struct DefaultScriptCompiler<{}>
@@ -0,0 +1,19 @@
+#include "frame_hook.h"
+#include "actor_extension.h"
+#include "frame_profiler.h"
+#include "spawn_queue.h"
+
+void DisableButtons(); // buttonDisabler.cpp
+
+unsigned FrameHook::frameCount = 0;
+
+void hook_0202bbe4()
+{
+	FrameHook::frameCount++;
+
+	FrameProfiler::OnFrame();
+	FinishActorConstruction();
+
+	DisableButtons();
+	SpawnQueue::Update();
+}
@@ -0,0 +1,13 @@
+#ifndef FRAME_HOOK_INCLUDED
+#define FRAME_HOOK_INCLUDED
+
+// The game reads the input exactly once per frame, in levels as well as in menus
+// and while paused. hook_0202bbe4 in frame_hook.cpp runs right after that, and
+// calls the code that has to run once per frame, so that each module doesn't
+// need a hook of its own in some actor's behavior.
+namespace FrameHook
+{
+	extern unsigned frameCount; // frames since the game was started
+}
+
+#endif
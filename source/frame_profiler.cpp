@@ -0,0 +1,295 @@
+#include "frame_profiler.h"
+#include "vtable_hook.h"
+
+#if FRAME_PROFILE
+
+#include <algorithm>
+#include <array>
+
+using namespace FrameProfiler;
+
+constexpr unsigned maxClasses = 64; // a power of 2
+constexpr unsigned maxVTables = 64;
+constexpr unsigned maxDepth = 16;
+constexpr unsigned numWorstClasses = 3;
+
+struct ClassProfile
+{
+	uint16_t actorID;
+	bool isUsed;
+	std::array<unsigned, NUM_PHASES> ticks; // since the last report
+	unsigned frameTicks;
+};
+
+struct Frame
+{
+	ClassProfile* classProfile;
+	Phase phase;
+};
+
+// The last one is for the classes that don't fit
+static constinit std::array<ClassProfile, maxClasses + 1> classes = {};
+static constinit VTableHook::Table<int(*)(ActorBase*), maxVTables> behaviors = {};
+static constinit VTableHook::Table<int(*)(ActorBase*), maxVTables> renders = {};
+static constinit std::array<Frame, maxDepth> stack = {};
+static constinit unsigned depth = 0;
+static constinit unsigned lastTick = 0;
+static constinit bool isBarDrawn = false;
+static constinit unsigned frameID = 0;
+static constinit unsigned framesSinceReport = 0;
+static constinit unsigned lastFrameTicks = 0;
+
+static ClassProfile& FindClass(unsigned actorID)
+{
+	for (unsigned i = actorID * 2654435761u >> 26, n = 0; n < maxClasses; i = (i + 1) % maxClasses, n++)
+	{
+		ClassProfile& res = classes[i];
+
+		if (!res.isUsed)
+		{
+			res.actorID = actorID;
+			res.isUsed = true;
+		}
+
+		if (res.actorID == actorID)
+			return res;
+	}
+
+	return classes[maxClasses];
+}
+
+// Charges the time since the previous call to the scope that's running
+static void Charge(unsigned now)
+{
+	if (depth != 0 && depth <= maxDepth)
+	{
+		const auto [classProfile, phase] = stack[depth - 1];
+		const unsigned ticks = now - lastTick;
+
+		classProfile->ticks[phase] += ticks;
+		classProfile->frameTicks += ticks;
+	}
+
+	lastTick = now;
+}
+
+void FrameProfiler::Enter(Phase phase, unsigned actorID)
+{
+	HWTimer::Start();
+	Charge(HWTimer::Read());
+
+	if (depth < maxDepth)
+		stack[depth] = {&FindClass(actorID), phase};
+
+	depth++;
+}
+
+void FrameProfiler::Leave()
+{
+	Charge(HWTimer::Read());
+	depth--;
+}
+
+static unsigned ToCycles(unsigned ticks, unsigned numFrames = 1)
+{
+	return HWTimer::TicksToCycles(ticks) / numFrames;
+}
+
+static void PrintClass(const ClassProfile& classProfile)
+{
+	if (&classProfile == &classes[maxClasses])
+		cout << "other actors";
+	else
+		cout << "actor " << static_cast<unsigned>(classProfile.actorID);
+}
+
+[[gnu::target("thumb")]]
+static void PrintOverBudget(unsigned frameTicks)
+{
+	std::array<const ClassProfile*, numWorstClasses> worst = {};
+
+	for (const ClassProfile& classProfile : classes)
+	{
+		const ClassProfile* candidate = &classProfile;
+
+		for (const ClassProfile*& slot : worst)
+		{
+			if (!slot || candidate->frameTicks > slot->frameTicks)
+				std::swap(slot, candidate);
+
+			if (!candidate) break;
+		}
+	}
+
+	cout << "frame " << frameID << " over budget: " << ToCycles(frameTicks) << " of " << ToCycles(frameBudget) << " cycles, worst:";
+
+	for (const ClassProfile* classProfile : worst)
+	{
+		if (classProfile->frameTicks == 0) break;
+
+		cout << " ";
+		PrintClass(*classProfile);
+		cout << " " << ToCycles(classProfile->frameTicks);
+	}
+
+	cout << "\n";
+}
+
+[[gnu::target("thumb")]]
+static void PrintReport()
+{
+	std::array<ClassProfile*, maxClasses + 1> sorted;
+	std::array<unsigned, NUM_PHASES> totals = {};
+	unsigned numUsed = 0;
+
+	for (ClassProfile& classProfile : classes)
+	{
+		if (!classProfile.isUsed) continue;
+
+		sorted[numUsed++] = &classProfile;
+
+		for (unsigned phase = 0; phase < NUM_PHASES; phase++)
+			totals[phase] += classProfile.ticks[phase];
+	}
+
+	const auto Total = [](const ClassProfile* classProfile)
+	{
+		unsigned res = 0;
+		for (unsigned ticks : classProfile->ticks) res += ticks;
+
+		return res;
+	};
+
+	const unsigned numPrinted = std::min(numUsed, numReportedClasses);
+	std::partial_sort(sorted.begin(), sorted.begin() + numPrinted, sorted.begin() + numUsed,
+		[&](const ClassProfile* a, const ClassProfile* b) { return Total(a) > Total(b); });
+
+	const auto PrintPhases = [](const std::array<unsigned, NUM_PHASES>& ticks)
+	{
+		for (unsigned phase = 0; phase < NUM_PHASES; phase++)
+			cout << (phase == 0 ? ": " : ", ") << ToCycles(ticks[phase], reportInterval);
+
+		cout << "\n";
+	};
+
+	cout << "Frame profile (cycles per frame in behavior, render, scripts):\n";
+	cout << "all actors";
+	PrintPhases(totals);
+
+	for (unsigned i = 0; i < numPrinted; i++)
+	{
+		PrintClass(*sorted[i]);
+		PrintPhases(sorted[i]->ticks);
+	}
+
+	for (ClassProfile& classProfile : classes)
+		classProfile.ticks = {};
+}
+
+void FrameProfiler::EndFrame()
+{
+	unsigned frameTicks = 0;
+	for (const ClassProfile& classProfile : classes)
+		frameTicks += classProfile.frameTicks;
+
+	if (frameTicks > frameBudget)
+		PrintOverBudget(frameTicks);
+
+	for (ClassProfile& classProfile : classes)
+		classProfile.frameTicks = 0;
+
+	if (++framesSinceReport == reportInterval)
+	{
+		PrintReport();
+		framesSinceReport = 0;
+	}
+
+	lastFrameTicks = frameTicks;
+	isBarDrawn = false;
+	frameID++;
+}
+
+enum GXCommand : uint16_t
+{
+	MTX_MODE       = 0x440,
+	MTX_PUSH       = 0x444,
+	MTX_POP        = 0x448,
+	MTX_IDENTITY   = 0x454,
+	COLOR          = 0x480,
+	VTX_16         = 0x48c,
+	POLYGON_ATTR   = 0x4a4,
+	TEXIMAGE_PARAM = 0x4a8,
+	BEGIN_VTXS     = 0x500,
+	END_VTXS       = 0x504,
+};
+
+static void Send(GXCommand command, uint32_t param = 0)
+{
+	*reinterpret_cast<volatile uint32_t*>(0x04000000 + command) = param;
+}
+
+static void Vertex(int x, int y)
+{
+	Send(VTX_16, (x & 0xffff) | y << 16);
+	Send(VTX_16, -0xfff & 0xffff); // in front of everything
+}
+
+// Half of the width of the screen is the budget. The quad is in clip space, so
+// both matrices are replaced while it's drawn. Afterwards, the matrix mode is
+// back to position & vector, which the game's rendering expects.
+[[gnu::target("thumb")]]
+static void DrawBar(unsigned frameTicks)
+{
+	const int right = -0x1000 + static_cast<int>(std::min(frameTicks / (frameBudget >> 12), 0x2000u));
+	const int top = 0x1000, bottom = 0x1000 - 0x100;
+
+	Send(MTX_MODE, 0);
+	Send(MTX_PUSH);
+	Send(MTX_IDENTITY);
+	Send(MTX_MODE, 2);
+	Send(MTX_PUSH);
+	Send(MTX_IDENTITY);
+
+	Send(POLYGON_ATTR, 31 << 16 | 1 << 7 | 1 << 6); // opaque, both sides
+	Send(TEXIMAGE_PARAM, 0);
+	Send(COLOR, frameTicks > frameBudget ? 0x001f : 0x03e0);
+
+	Send(BEGIN_VTXS, 1); // quads
+	Vertex(-0x1000, top);
+	Vertex(-0x1000, bottom);
+	Vertex(right, bottom);
+	Vertex(right, top);
+	Send(END_VTXS);
+
+	Send(MTX_POP, 1);
+	Send(MTX_MODE, 0);
+	Send(MTX_POP, 1);
+	Send(MTX_MODE, 2);
+}
+
+static int TimedBehavior(ActorBase* actor)
+{
+	Scope scope(BEHAVIOR, actor->actorID);
+	return behaviors.OriginalOf(*actor)(actor);
+}
+
+static int TimedRender(ActorBase* actor)
+{
+	// The bar is drawn with the first actor, so that it's in every frame
+	if (showBar && !isBarDrawn)
+	{
+		DrawBar(lastFrameTicks);
+		isBarDrawn = true;
+	}
+
+	Scope scope(RENDER, actor->actorID);
+	return renders.OriginalOf(*actor)(actor);
+}
+
+void FrameProfiler::WrapClass(Actor& actor)
+{
+	behaviors.Wrap(actor, VTableHook::IndexOf(&ActorBase::Behavior), &TimedBehavior);
+	renders.Wrap(actor, VTableHook::IndexOf(&ActorBase::Render), &TimedRender);
+}
+
+#endif
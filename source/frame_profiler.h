@@ -0,0 +1,74 @@
+#ifndef FRAME_PROFILER_INCLUDED
+#define FRAME_PROFILER_INCLUDED
+
+#include "SM64DS_PI.h"
+#include "hw_timer.h"
+
+// Set this to 1 to measure how much time each actor class takes per frame in
+// each phase, using the hardware timers (see hw_timer.h). Every reportInterval
+// frames, the classes that took the most time are printed to the debug output,
+// and every frame that goes over the budget is printed with its worst classes.
+//
+// Only the time spent in the Behavior and Render of actors and in Kuppa Script
+// instructions is measured. The rest of the frame, like the game's own collision
+// and scene code and waiting for the vblank, isn't part of any phase, so the
+// budget is only checked against the time of the phases.
+#ifndef FRAME_PROFILE
+#define FRAME_PROFILE 0
+#endif
+
+namespace FrameProfiler
+{
+	constexpr bool enabled = FRAME_PROFILE;
+	constexpr bool showBar = false; // draws the time of the last frame as a bar at the top of the main screen
+	constexpr unsigned reportInterval = 60;
+	constexpr unsigned numReportedClasses = 8;
+	constexpr unsigned frameBudget = HWTimer::ticksPerSecond / 60;
+
+	enum Phase : uint8_t
+	{
+		BEHAVIOR,
+		RENDER,
+		SCRIPTS,
+
+		NUM_PHASES
+	};
+
+	void Enter(Phase phase, unsigned actorID);
+	void Leave();
+	void WrapClass(Actor& actor);
+	void EndFrame();
+
+	// Charges the time until it's destroyed to the phase and the actor class,
+	// except for the time of the scopes inside it, which is charged to theirs
+	struct Scope
+	{
+		[[gnu::always_inline]]
+		Scope(Phase phase, unsigned actorID)
+		{
+			if constexpr (enabled) Enter(phase, actorID);
+		}
+
+		[[gnu::always_inline]]
+		~Scope()
+		{
+			if constexpr (enabled) Leave();
+		}
+	};
+
+	// Called for every new actor by FinishActorConstruction. The behavior and
+	// render of each class are timed by replacing them in its vtable the first
+	// time an actor of it is constructed.
+	inline void OnActorConstructed(Actor& actor)
+	{
+		if constexpr (enabled) WrapClass(actor);
+	}
+
+	// Called once per frame by frame_hook.cpp
+	inline void OnFrame()
+	{
+		if constexpr (enabled) EndFrame();
+	}
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifdef FUNC_PROFILE
+
+#include "hw_timer.h"
+
+// Built by make PROFILE=1, which compiles everything else with -finstrument-functions.
+// It measures the time spent in each function, without the time spent in the
+// functions it calls unless they're in the game, and prints it every few seconds
+// for tools/codegen_select. The profile is reset after each print.
+namespace FuncProfiler
+{
+	constexpr unsigned maxFunctions = 512; // a power of 2
+	constexpr unsigned maxDepth = 64;
+	constexpr unsigned printInterval = 10 * HWTimer::ticksPerSecond;
+
+	struct Entry
+	{
+		uintptr_t func;
+		unsigned ticks;
+		unsigned calls;
+	};
+
+	static constinit Entry entries[maxFunctions] = {};
+	static constinit Entry* stack[maxDepth] = {};
+	static constinit unsigned depth = 0;
+	static constinit unsigned lastTick = 0;
+	static constinit unsigned lastPrint = 0;
+	static constinit unsigned numDropped = 0;
+	static constinit bool isPrinting = false;
+
+	static Entry* Find(uintptr_t func)
+	{
+		for (unsigned i = (func >> 1) * 2654435761u >> 23, n = 0; n < maxFunctions; i = (i + 1) % maxFunctions, n++)
+		{
+			if (entries[i].func == func)
+				return &entries[i];
+
+			if (entries[i].func == 0)
+			{
+				entries[i].func = func;
+				return &entries[i];
+			}
+		}
+
+		numDropped++;
+		return nullptr;
+	}
+
+	// Charges the time since the previous call to the function that's running
+	static void Charge(unsigned now)
+	{
+		if (depth != 0 && depth <= maxDepth && stack[depth - 1])
+			stack[depth - 1]->ticks += now - lastTick;
+
+		lastTick = now;
+	}
+
+	[[gnu::target("thumb")]]
+	static void Print()
+	{
+		isPrinting = true;
+
+		cout << "Function profile (prof address ticks calls):\n";
+
+		for (Entry& entry : entries)
+		{
+			if (entry.calls != 0)
+				cout << "prof " << entry.func << " " << entry.ticks << " " << entry.calls << "\n";
+
+			entry = {};
+		}
+
+		if (numDropped != 0)
+			cout << "prof dropped " << numDropped << "\n";
+
+		numDropped = 0;
+		isPrinting = false;
+	}
+}
+
+using namespace FuncProfiler;
+
+extern "C" void __cyg_profile_func_enter(void* func, void* callSite)
+{
+	if (isPrinting) return;
+
+	HWTimer::Start();
+	Charge(HWTimer::Read());
+
+	Entry* entry = Find(reinterpret_cast<uintptr_t>(func) & ~1u);
+	if (entry) entry->calls++;
+
+	if (depth < maxDepth)
+		stack[depth] = entry;
+
+	depth++;
+}
+
+extern "C" void __cyg_profile_func_exit(void* func, void* callSite)
+{
+	if (isPrinting || depth == 0) return;
+
+	const unsigned now = HWTimer::Read();
+	Charge(now);
+
+	if (--depth == 0 && now - lastPrint >= printInterval)
+	{
+		Print();
+
+		lastPrint = now;
+		lastTick = HWTimer::Read(); // don't charge the printing to the next function
+	}
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef HW_TIMER_INCLUDED
+#define HW_TIMER_INCLUDED
+
+#include "SM64DS_PI.h"
+
+#ifndef ARM9
+#include <chrono>
+#endif
+
+// A 32-bit counter made of two cascaded ARM9 hardware timers. It runs at the bus
+// clock rate (33.514 MHz), which is half of the ARM9 clock rate, and wraps around
+// after about two minutes, so differences between readings are always valid.
+//
+// On the host, like in tools/ks_sim, the counter is made from the steady clock,
+// so the code that uses it can be built there and gets real timings.
+namespace HWTimer
+{
+	constexpr unsigned firstTimer = 2; // timers 2 and 3 aren't used by the game
+	constexpr unsigned cyclesPerTick = 2;
+	constexpr unsigned ticksPerSecond = 33'513'982;
+
+	constexpr unsigned TicksToCycles(unsigned ticks)
+	{
+		return ticks * cyclesPerTick;
+	}
+
+#ifdef ARM9
+	constexpr uint16_t ENABLE  = 1 << 7;
+	constexpr uint16_t CASCADE = 1 << 2;
+
+	inline volatile uint16_t& Counter(unsigned timerID)
+	{
+		return *reinterpret_cast<volatile uint16_t*>(0x04000100 + 4 * timerID);
+	}
+
+	inline volatile uint16_t& Control(unsigned timerID)
+	{
+		return *reinterpret_cast<volatile uint16_t*>(0x04000102 + 4 * timerID);
+	}
+
+	inline bool IsRunning()
+	{
+		return Control(firstTimer) & ENABLE;
+	}
+
+	inline void Start()
+	{
+		if (IsRunning()) return;
+
+		Counter(firstTimer)     = 0; // reload values
+		Counter(firstTimer + 1) = 0;
+
+		Control(firstTimer + 1) = ENABLE | CASCADE;
+		Control(firstTimer)     = ENABLE; // prescaler F/1
+	}
+
+	[[gnu::always_inline]]
+	inline unsigned Read()
+	{
+		unsigned high, low;
+
+		do
+		{
+			high = Counter(firstTimer + 1);
+			low  = Counter(firstTimer);
+		}
+		while (high != Counter(firstTimer + 1));
+
+		return high << 16 | low;
+	}
+#else
+	inline const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	inline void Start() {}
+
+	inline unsigned Read()
+	{
+		const std::chrono::duration<double> time = std::chrono::steady_clock::now() - startTime;
+
+		return static_cast<uint64_t>(time.count() * ticksPerSecond); // wraps around like the timers
+	}
+#endif
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "SM64DS_PI.h"
+#include "warp_pipe_table.h"
 
 asm(R"(
 nsub_020b0be4_ov_02:
@@ -29,20 +30,6 @@ constexpr uint8_t framesBeforeSound = framesBeforeSpawn + framesFromSpawnToSound
 extern char unk_0209f2fc;
 asm("unk_0209f2fc = 0x0209f2fc");
 
-static bool IsActorNear(const Vector3& pos, uint16_t actorID)
-{
-	Actor* warpPipe = nullptr;
-	while ((warpPipe = Actor::FindWithActorID(actorID, warpPipe)) && warpPipe->pos.Dist(pos) >= 300._f);
-	return warpPipe;
-}
-
-static bool IsWarpPipeNear(const Vector3& pos)
-{
-	// return IsActorNear(pos, 298) || IsActorNear(pos, MOM_IDs::COLORED_PIPE);
-
-	return IsActorNear(pos, 298);
-}
-
 extern "C" bool ShouldExitNormally(const Actor& exit, Player& player)
 {
 	if (exit.param1 >> 0x18 != static_cast<u32>(LEVEL_ID)) [[likely]]
@@ -53,7 +40,7 @@ extern "C" bool ShouldExitNormally(const Actor& exit, Player& player)
 	func_020ca1b8(player, 6, -1, 0);
 	func_0200d048(*CAMERA);
 
-	if (IsWarpPipeNear(exit.pos))
+	if (WarpPipeTable::IsNearPipe(exit.pos))
 		Sound::UnkPlaySoundFunc(22);
 	else
 		Sound::UnkPlaySoundFunc(NEXT_LEVEL_ID == 13 ? 30 : 25); // play the painting sound when entering HMC?
@@ -74,6 +61,70 @@ SpawnActorBase = 0x02042ffc
 
 extern "C" ActorBase* SpawnActorBase(unsigned actorID, ActorBase* parent, unsigned param1, int unk03);
 
+// Entrance modes that don't need the spawn animation of a new player, so the
+// existing player can be moved to the entrance instead of being respawned
+constexpr uint16_t inPlaceEntranceModes = 1 << 0;
+
+static bool CanWarpInPlace(unsigned entranceMode)
+{
+	return inPlaceEntranceModes >> entranceMode & 1;
+}
+
+// Yoshi's egg stays behind at the exit otherwise
+static void DestroyEgg(Player& player)
+{
+	if (player.eggPtrArr && player.eggPtrArr[0])
+		player.eggPtrArr[0]->MarkForDestruction();
+}
+
+static void WarpPlayerInPlace(Player& player, const Vector3& pos, const Vector3_16& ang, unsigned areaID, unsigned entranceMode)
+{
+	player.pos = pos;
+	player.prevPos = pos;
+	player.ang = ang;
+	player.motionAng = ang;
+	player.horzSpeed = 0_f;
+	player.speed.x = player.speed.y = player.speed.z = 0_f;
+	player.areaID = areaID;
+	player.param1 = player.param1 & ~(0xf << 8) | entranceMode << 8;
+
+	// The player keeps existing, so it mustn't point to the egg after it's destroyed
+	DestroyEgg(player);
+	if (player.eggPtrArr) player.eggPtrArr[0] = nullptr;
+
+	player.ChangeState(Player::ST_WAIT);
+}
+
+static void RespawnPlayer(Player& player, const Vector3& pos, const Vector3_16& ang, unsigned areaID, unsigned entranceMode)
+{
+	const int param1 = player.realChar | (player.param1 & 3) << 3 | player.playerID << 6 | entranceMode << 8;
+
+	PLAYER_ARR[0] = static_cast<Player*>(Actor::Spawn(player.actorID, param1, pos, &ang, areaID, -1));
+
+	DestroyEgg(player);
+
+	player.KillAndTrackInDeathTable();
+}
+
+static void RespawnCamera(unsigned viewID)
+{
+	CAMERA->MarkForDestruction();
+	CAMERA = static_cast<Camera*>(SpawnActorBase(CAMERA->actorID, ROOT_ACTOR_BASE, viewID, 0));
+}
+
+// The camera only needs to be respawned if the view changes.
+// Otherwise it's moved along with the player so that it doesn't pan across the level.
+static void UpdateCamera(const Vector3& playerOffset, unsigned viewID)
+{
+	if (CAMERA->param1 == viewID)
+	{
+		CAMERA->pos += playerOffset;
+		CAMERA->lookAt += playerOffset;
+	}
+	else
+		RespawnCamera(viewID);
+}
+
 extern "C" Player& UpdateIntraLevelWarp(Player& player)
 {
 	if (warpFrameCounter == 0 || (--warpFrameCounter != 0 && warpFrameCounter != framesFromSpawnToSound))
@@ -84,7 +135,7 @@ extern "C" Player& UpdateIntraLevelWarp(Player& player)
 
 	if (warpFrameCounter == 0)
 	{
-		if (IsWarpPipeNear(pos)) Sound::UnkPlaySoundFunc(22);
+		if (WarpPipeTable::IsEntranceNearPipe(entranceID)) Sound::UnkPlaySoundFunc(22);
 
 		return player;
 	}
@@ -93,17 +144,20 @@ extern "C" Player& UpdateIntraLevelWarp(Player& player)
 	const unsigned areaID = entrance.param1 & 7;
 	const unsigned entranceMode = entrance.param1 >> 7 & 0xf;
 
-	const int param1 = player.realChar | (player.param1 & 3) << 3 | player.playerID << 6 | entranceMode << 8;
-
-	PLAYER_ARR[0] = static_cast<Player*>(Actor::Spawn(player.actorID, param1, pos, &entrance.ang, areaID, -1));
-
-	if (player.eggPtrArr && player.eggPtrArr[0])
-		player.eggPtrArr[0]->MarkForDestruction();
+	const Vector3 playerOffset = pos - player.pos;
 
-	player.KillAndTrackInDeathTable();
-
-	CAMERA->MarkForDestruction();
-	CAMERA = static_cast<Camera*>(SpawnActorBase(CAMERA->actorID, ROOT_ACTOR_BASE, viewID, 0));
+	// Only entrance mode 0 (see inPlaceEntranceModes) moves the existing player,
+	// every other mode respawns it to play the animation of the entrance
+	if (CanWarpInPlace(entranceMode))
+	{
+		WarpPlayerInPlace(player, pos, entrance.ang, areaID, entranceMode);
+		UpdateCamera(playerOffset, viewID);
+	}
+	else
+	{
+		RespawnPlayer(player, pos, entrance.ang, areaID, entranceMode);
+		RespawnCamera(viewID);
+	}
 
 	return player;
 }
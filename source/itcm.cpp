@@ -0,0 +1,12 @@
+#include "itcm.h"
+#include <cstring>
+
+extern char __itcm_start[];
+extern char __itcm_end[];
+extern const char __itcm_load[];
+
+void ITCM::Init()
+{
+	// ITCM isn't cached and DMA can't reach it, so a plain copy is enough
+	std::memcpy(__itcm_start, __itcm_load, __itcm_end - __itcm_start);
+}
@@ -0,0 +1,29 @@
+#ifndef ITCM_INCLUDED
+#define ITCM_INCLUDED
+
+// Functions marked with ITCM_CODE are copied into the free part of ITCM by
+// ITCM::Init at boot, where they're fetched without wait states and don't
+// compete with everything else for the instruction cache. There are only
+// 0x20c0 bytes, which linker.x checks, so it's for the hottest functions.
+//
+// ITCM is within BL range of all of main RAM, and ld adds the veneers that
+// calls between ARM and Thumb code need, so calls work as usual.
+//
+// Hooks and the functions nsub_/repl_ symbols point to are only called by the
+// game, so --gc-sections would drop them. They're marked with ITCM_HOOK instead,
+// which linker.x always keeps.
+#ifdef ARM9
+#define ITCM_CODE [[gnu::section(".itcm"), gnu::target("arm")]]
+#define ITCM_HOOK [[gnu::section(".itcm.hook"), gnu::target("arm")]]
+#else
+#define ITCM_CODE
+#define ITCM_HOOK
+#endif
+
+namespace ITCM
+{
+	// Called by the constructor of MultiHeap before anything can use ITCM_CODE
+	void Init();
+}
+
+#endif
@@ -1,36 +1,391 @@
+// Tests for the replacement libc in the libc directory.
+//
+// In the ARM9 build with LIBC_BENCHMARK defined as 1, this times memcpy, memmove,
+// memset and memcmp with the hardware timers for sizes from 1 byte to 64 KiB and a
+// few alignments, checks their results, prints the number of cycles per byte with
+// the debug output and then starts the game. This takes a few seconds at every boot.
+//
+// On a host, this is a fuzzer that compares the replacement functions to the ones of
+// the host's C library with every combination of alignment, size and overlap.
+// See tools/libc_test for building it.
+
 #include <cstring>
 
+#ifndef LIBC_BENCHMARK
+#define LIBC_BENCHMARK 0
+#endif
+
+#ifdef ARM9
+#if LIBC_BENCHMARK
+
+#include <algorithm>
+#include "hw_timer.h"
+#include "memory_map.h"
+
 asm("MainLoop = 0x020197b8");
 extern "C" [[noreturn]] void MainLoop();
 
-constinit char a[10] = {};
-constinit char b[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+constexpr size_t maxSize = 0x10000;
+constexpr size_t padding = 0x40;
 
-constinit unsigned s = sizeof(a);
+// The benchmark runs before the heaps are set up, so the unused memory after
+// DTCM is still free. It's only handed to its heap by the MultiHeap constructor
+// in multiheap.cpp.
+constexpr uintptr_t benchmarkBufferStart = DTCM_END;
+constexpr size_t benchmarkBufferSize = 2 * (maxSize + padding); // destination and source
+static_assert(benchmarkBufferStart + benchmarkBufferSize <= FLASHCARD_CODE_START,
+	"the benchmark buffer would overwrite the flashcard code");
 
-void copy()
+static char* const destBuffer = reinterpret_cast<char*>(benchmarkBufferStart);
+static char* const srcBuffer  = destBuffer + maxSize + padding;
+
+// The contents of the source buffer before a routine is checked
+static char PatternAt(const char* ptr)
 {
-	std::memcpy(a, b, s);
+	return (ptr - srcBuffer) * 7;
+}
+
+static void FillPattern(size_t size)
+{
+	for (char* ptr = srcBuffer; ptr < srcBuffer + size; ptr++)
+		*ptr = PatternAt(ptr);
+}
+
+template<class F>
+static bool ForAll(size_t size, F&& isCorrectAt)
+{
+	for (size_t i = 0; i < size; i++)
+		if (!isCorrectAt(i)) return false;
+
+	return true;
+}
+
+constinit volatile int sink = 0;
+
+struct Routine
+{
+	const char* name;
+	void (*run)(char* dest, char* src, size_t size);
+	bool (*isCorrect)(const char* dest, const char* src, size_t size); // after one run with the pattern in the source
+};
+
+// The memmove ones move the source by 4 bytes up and down, which
+// covers both directions of overlapping moves. The destination is
+// a copy of the source for memcmp, so that it compares everything.
+constexpr Routine routines[] =
+{
+	{
+		"memcpy",
+		[](char* dest, char* src, size_t size) { std::memcpy(dest, src, size); },
+		[](const char* dest, const char* src, size_t size) { return ForAll(size, [=](size_t i) { return dest[i] == src[i]; }); }
+	},
+	{
+		"memmove+4",
+		[](char* dest, char* src, size_t size) { std::memmove(src + 4, src, size); },
+		[](const char* dest, const char* src, size_t size) { return ForAll(size, [=](size_t i) { return src[i + 4] == PatternAt(src + i); }); }
+	},
+	{
+		"memmove-4",
+		[](char* dest, char* src, size_t size) { std::memmove(src, src + 4, size); },
+		[](const char* dest, const char* src, size_t size) { return ForAll(size, [=](size_t i) { return src[i] == PatternAt(src + i + 4); }); }
+	},
+	{
+		"memset",
+		[](char* dest, char* src, size_t size) { std::memset(dest, 0x5a, size); },
+		[](const char* dest, const char* src, size_t size) { return ForAll(size, [=](size_t i) { return dest[i] == 0x5a; }); }
+	},
+	{
+		"memcmp",
+		[](char* dest, char* src, size_t size) { sink = std::memcmp(dest, src, size); },
+		[](const char* dest, const char* src, size_t size) { return sink == 0; }
+	},
+};
+
+struct Alignment
+{
+	unsigned destOffset;
+	unsigned srcOffset;
+};
+
+constexpr Alignment alignments[] = {{0, 0}, {1, 1}, {0, 1}, {0, 2}, {2, 0}};
+
+static void Nop(char* dest, char* src, size_t size) {}
+
+static unsigned Measure(void (*run)(char*, char*, size_t), char* dest, char* src, size_t size)
+{
+	const unsigned repeats = std::max<unsigned>(0x4000 / size, 4);
+
+	run(dest, src, size); // warm up the cache
+
+	const unsigned start = HWTimer::Read();
+
+	for (unsigned i = 0; i < repeats; i++)
+		run(dest, src, size);
+
+	return HWTimer::TicksToCycles(HWTimer::Read() - start) / repeats;
 }
 
-void move()
+static void PrintHundredths(unsigned val)
 {
-	std::memmove(a + 5, a, 5);
-	std::memmove(b, b + 5, 5);
+	cout << static_cast<int>(val / 100) << (val % 100 < 10 ? ".0" : ".") << static_cast<int>(val % 100);
 }
 
-void set()
+static void RunBenchmark()
 {
-	std::memset(a + 1, 0xff, 8);
+	HWTimer::Start();
+
+	const unsigned overhead = Measure(Nop, destBuffer, srcBuffer, 1);
+
+	cout << "routine size dest+ src+: cycles, cycles per byte\n";
+
+	for (const Routine& routine : routines)
+	{
+		for (size_t size = 1; size <= maxSize; size *= 2)
+		{
+			for (const auto [destOffset, srcOffset] : alignments)
+			{
+				char* const dest = destBuffer + destOffset;
+				char* const src  = srcBuffer + srcOffset;
+
+				// Checked before the timing, which moves the source around
+				FillPattern(srcOffset + size + 4);
+				std::memcpy(dest, src, size);
+
+				routine.run(dest, src, size);
+				const bool isCorrect = routine.isCorrect(dest, src, size);
+
+				const unsigned measured = Measure(routine.run, dest, src, size);
+				const unsigned cycles = measured > overhead ? measured - overhead : 0;
+
+				cout << routine.name << " " << static_cast<int>(size) << " " << static_cast<int>(destOffset)
+					<< " " << static_cast<int>(srcOffset) << ": " << static_cast<int>(cycles) << ", ";
+
+				PrintHundredths(cycles * 100 / size);
+
+				if (!isCorrect)
+					cout << " MISMATCH";
+
+				cout << "\n";
+			}
+		}
+	}
 }
 
 void repl_02007040()
 {
 	asm("mov r11, r11");
 
-	copy();
-	move();
-	set();
+	RunBenchmark();
 
 	MainLoop();
 }
+
+#endif
+#else
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdint>
+
+// The replacement functions are renamed when building for a host
+extern "C"
+{
+	void* test_memcpy(void* dest, const void* src, size_t size);
+	void* test_memmove(void* dest, const void* src, size_t size);
+	void* test_memset(void* dest, int val, size_t size);
+	size_t test_strlen(const char* str);
+	int test_strcmp(const char* str1, const char* str2);
+	char* test_strncpy(char* dest, const char* src, size_t size);
+	int test_memcmp(const void* ptr1, const void* ptr2, size_t size);
+	void* test_memchr(const void* ptr, int val, size_t size);
+}
+
+constexpr size_t bufferSize = 0x4000;
+constexpr size_t maxOffset = 8;
+
+using Buffer = std::array<char, bufferSize>;
+
+static Buffer expected, actual;
+static unsigned numChecks = 0, numFailures = 0;
+
+static constexpr auto sizes = []
+{
+	std::array<size_t, 161 + 12> res = {};
+
+	for (size_t i = 0; i <= 160; i++)
+		res[i] = i;
+
+	constexpr size_t largeSizes[] = {255, 256, 257, 511, 512, 513, 1023, 1024, 2049, 4095, 4096, 6001};
+	std::ranges::copy(largeSizes, res.begin() + 161);
+
+	return res;
+}();
+
+static void Reset(char fill = 0)
+{
+	for (size_t i = 0; i < bufferSize; i++)
+		expected[i] = fill ? fill : static_cast<char>(i * 13 + i / 251);
+
+	actual = expected;
+}
+
+static void Check(bool ok, const char* name, size_t size, long arg1, long arg2 = 0)
+{
+	numChecks++;
+
+	if (ok) return;
+
+	if (numFailures++ < 20)
+		std::printf("%s failed: size %zu, %ld, %ld\n", name, size, arg1, arg2);
+}
+
+static int Sign(int x)
+{
+	return (x > 0) - (x < 0);
+}
+
+static void TestCopies()
+{
+	constexpr size_t srcStart = bufferSize / 2;
+
+	for (size_t size : sizes)
+	{
+		for (size_t destOffset = 0; destOffset < maxOffset; destOffset++)
+		{
+			for (size_t srcOffset = 0; srcOffset < maxOffset; srcOffset++)
+			{
+				char* const dest = &actual[64 + destOffset];
+
+				Reset();
+				std::memcpy(&expected[64 + destOffset], &expected[srcStart + srcOffset], size);
+				const void* res = test_memcpy(dest, &actual[srcStart + srcOffset], size);
+				Check(res == dest && actual == expected, "memcpy", size, destOffset, srcOffset);
+
+				Reset();
+				std::memmove(&expected[64 + destOffset], &expected[srcStart + srcOffset], size);
+				res = test_memmove(dest, &actual[srcStart + srcOffset], size);
+				Check(res == dest && actual == expected, "memmove", size, destOffset, srcOffset);
+			}
+
+			for (int val : {0, 0xff, 0x5a, 0x1234})
+			{
+				Reset();
+				std::memset(&expected[64 + destOffset], val, size);
+				const void* res = test_memset(&actual[64 + destOffset], val, size);
+				Check(res == &actual[64 + destOffset] && actual == expected, "memset", size, destOffset, val);
+			}
+		}
+	}
+}
+
+static void TestOverlappingMoves()
+{
+	constexpr long maxDistance = 72;
+	constexpr size_t base = bufferSize / 2;
+
+	for (size_t size : sizes)
+	{
+		for (size_t offset = 0; offset < maxOffset; offset++)
+		{
+			for (long distance = -maxDistance; distance <= maxDistance; distance++)
+			{
+				const size_t dest = base + offset;
+				const size_t src = dest + distance;
+
+				Reset();
+				std::memmove(&expected[dest], &expected[src], size);
+				test_memmove(&actual[dest], &actual[src], size);
+				Check(actual == expected, "overlapping memmove", size, offset, distance);
+			}
+		}
+	}
+}
+
+static void TestStrings()
+{
+	for (size_t length = 0; length <= 100; length++)
+	{
+		for (size_t offset1 = 0; offset1 < maxOffset; offset1++)
+		{
+			Reset('a');
+
+			char* const str1 = &actual[64 + offset1];
+			str1[length] = 0;
+
+			Check(test_strlen(str1) == length, "strlen", length, offset1);
+
+			for (size_t size = 0; size <= length + 10; size++)
+			{
+				for (size_t offset2 = 0; offset2 < maxOffset; offset2 += 3)
+				{
+					Buffer before = actual;
+					char* const dest = &actual[bufferSize / 2 + offset2];
+
+					std::strncpy(&before[bufferSize / 2 + offset2], str1, size);
+					const char* res = test_strncpy(dest, str1, size);
+					Check(res == dest && actual == before, "strncpy", size, offset1, offset2);
+
+					actual = expected;
+					str1[length] = 0;
+				}
+			}
+
+			for (size_t offset2 = 0; offset2 < maxOffset; offset2++)
+			{
+				char* const str2 = &actual[bufferSize / 2 + offset2];
+
+				std::memcpy(str2, str1, length + 1);
+
+				for (size_t diffPos = 0; diffPos <= length; diffPos++)
+				{
+					for (char diff : {'\0', 'b', '\x80'})
+					{
+						const char original = str2[diffPos];
+
+						if (diff != original)
+						{
+							str2[diffPos] = diff;
+
+							Check(Sign(test_strcmp(str1, str2)) == Sign(std::strcmp(str1, str2)),
+								"strcmp", length, offset1, offset2);
+							Check(Sign(test_memcmp(str1, str2, length)) == Sign(std::memcmp(str1, str2, length)),
+								"memcmp", length, offset1, offset2);
+						}
+
+						str2[diffPos] = original;
+					}
+				}
+
+				Check(test_strcmp(str1, str2) == 0, "strcmp", length, offset1, offset2);
+				Check(test_memcmp(str1, str2, length + 1) == 0, "memcmp", length, offset1, offset2);
+			}
+
+			for (size_t pos = 0; pos <= length; pos++)
+			{
+				str1[pos] = '\xfe';
+
+				for (size_t size : {pos, pos + 1, length + 1})
+				{
+					Check(test_memchr(str1, 0xfe, size) == std::memchr(str1, 0xfe, size), "memchr", size, offset1, pos);
+					Check(test_memchr(str1, 0x1fe, size) == std::memchr(str1, 0x1fe, size), "memchr", size, offset1, pos);
+				}
+
+				str1[pos] = 'a';
+			}
+		}
+	}
+}
+
+int main()
+{
+	TestCopies();
+	TestOverlappingMoves();
+	TestStrings();
+
+	std::printf("%u checks, %u failures\n", numChecks, numFailures);
+
+	return numFailures != 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef MEMORY_MAP_INCLUDED
+#define MEMORY_MAP_INCLUDED
+
+// The addresses the memory regions of multiheap.cpp are made of. They're macros
+// so that they can be put into the asm statements that define the regions.
+#define ITCM_ARENA_START     0x01ffdf40
+#define MAIN_RAM_START       0x02000000
+#define MAIN_RAM_CODE_START  0x02004000
+#define LEVEL_OVERLAY_START  0x0214eaa0
+#define INSERTED_CODE_START  0x02156aa0
+#define DTCM_START           0x023c0000
+#define DTCM_END             0x023c4000
+#define ARM7_ARENA_START     0x023d80e0
+#define FLASHCARD_CODE_START 0x023fc000
+
+#endif
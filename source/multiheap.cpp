@@ -1,18 +1,10 @@
 #include "SM64DS_PI.h"
+#include "itcm.h"
+#include "memory_map.h"
 #include <new>
 #include <array>
 #include <functional>
 
-#define ITCM_ARENA_START     0x01ffdf40
-#define MAIN_RAM_START       0x02000000
-#define MAIN_RAM_CODE_START  0x02004000
-#define LEVEL_OVERLAY_START  0x0214eaa0
-#define INSERTED_CODE_START  0x02156aa0
-#define DTCM_START           0x023c0000
-#define DTCM_END             0x023c4000
-#define ARM7_ARENA_START     0x023d80e0
-#define FLASHCARD_CODE_START 0x023fc000
-
 #define STR(x) #x
 #define REGION(name, start, end) extern char name[(end) - (start)]; \
 asm(#name " = " STR(start));
@@ -133,7 +125,7 @@ constinit extraHeaps;
 
 class MultiHeap : public ExpandingHeap
 {
-	ExpandingHeap& GetHeap(const void* ptr)
+	ITCM_CODE ExpandingHeap& GetHeap(const void* ptr)
 	{
 		for (const MemoryRange& extraHeapMemRange : extraHeaps.memRanges)
 		{
@@ -155,7 +147,7 @@ public:
 			extraHeap.Destroy();
 	}
 
-	virtual void* VAllocate(unsigned size, int align) override
+	ITCM_CODE virtual void* VAllocate(unsigned size, int align) override
 	{
 		for (ExpandingHeap& extraHeap : extraHeaps)
 		{
@@ -167,7 +159,7 @@ public:
 		return ExpandingHeap::VAllocate(size, align);
 	}
 
-	virtual bool VDeallocate(void* ptr) override
+	ITCM_CODE virtual bool VDeallocate(void* ptr) override
 	{
 		return GetHeap(ptr).ExpandingHeap::VDeallocate(ptr);
 	}
@@ -185,7 +177,7 @@ public:
 		return GetHeap(ptr).ExpandingHeap::VReallocate(ptr, newSize);
 	}
 
-	virtual unsigned VSizeof(const void* ptr) override
+	ITCM_CODE virtual unsigned VSizeof(const void* ptr) override
 	{
 		return GetHeap(ptr).ExpandingHeap::VSizeof(ptr);
 	}
@@ -235,6 +227,7 @@ public:
 MultiHeap::MultiHeap(void* start, unsigned size, Heap* root, ExpandingHeapAllocator* allocator):
 	ExpandingHeap(start, size, root, allocator)
 {
+	ITCM::Init();
 	extraHeaps.Init();
 }
 
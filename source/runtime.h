@@ -0,0 +1,30 @@
+#ifndef RUNTIME_INCLUDED
+#define RUNTIME_INCLUDED
+
+// The runtime DL exports libc and DMA to the DLs in RUNTIME_CLIENTS of
+// dynamic_lib/Makefile through a jump table, so that they don't each need their
+// own copy. It starts with a word holding the version and number of exports.
+//
+// The clients call the exports through stubs, which find the table in the import
+// slot of the DL. Until the loader replaces it with the address of the table, the
+// slot holds the version and number of exports the DL was built with, which the
+// loader checks with IsCompatible.
+#define RUNTIME_VERSION 1
+
+#ifndef __ASSEMBLER__
+#include <cstdint>
+
+namespace Runtime
+{
+	constexpr unsigned version = RUNTIME_VERSION;
+
+	// Exports are only added at the end, so a table with the same version
+	// and at least as many exports works with a DL built for an older one
+	constexpr bool IsCompatible(uint32_t tableInfo, uint32_t requiredInfo)
+	{
+		return tableInfo >> 16 == requiredInfo >> 16 && (tableInfo & 0xffff) >= (requiredInfo & 0xffff);
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+// The functions the runtime DL exports, in the order of its jump table. This is
+// included by C++ and assembly, so it can only contain RUNTIME_EXPORT lines.
+// New exports go at the end, changing or removing one needs a new RUNTIME_VERSION.
+//
+// RUNTIME_EXPORT(symbol, function)
+
+RUNTIME_EXPORT(memcpy, memcpy)
+RUNTIME_EXPORT(memmove, memmove)
+RUNTIME_EXPORT(memset, memset)
+RUNTIME_EXPORT(memcmp, memcmp)
+RUNTIME_EXPORT(strlen, strlen)
+RUNTIME_EXPORT(strcmp, strcmp)
+RUNTIME_EXPORT(strncpy, strncpy)
+RUNTIME_EXPORT(_ZN3DMA7CanCopyEPKvS1_j, DMA::CanCopy)
+RUNTIME_EXPORT(_ZN3DMA7CanFillEPKvj, DMA::CanFill)
+RUNTIME_EXPORT(_ZN3DMA9StartCopyEPvPKvj, DMA::StartCopy)
+RUNTIME_EXPORT(_ZN3DMA9StartFillEPvhj, DMA::StartFill)
+RUNTIME_EXPORT(_ZN3DMA6IsBusyEv, DMA::IsBusy)
+RUNTIME_EXPORT(_ZN3DMA4WaitEv, DMA::Wait)
+RUNTIME_EXPORT(memchr, memchr)
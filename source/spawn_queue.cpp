@@ -0,0 +1,147 @@
+#include "spawn_queue.h"
+#include "hw_timer.h"
+#include <array>
+
+constexpr unsigned queueSize = 32;
+
+struct Request
+{
+	Vector3 pos;
+	Vector3_16 ang;
+	bool hasAng;
+	uint8_t levelID;
+	uint16_t actorID;
+	int8_t areaID;
+	unsigned param1;
+	int deathTableID;
+	SpawnQueue::Callback callback;
+	void* userData;
+};
+
+// A ring buffer of requests with the same priority
+struct Queue
+{
+	std::array<Request, queueSize> requests;
+	unsigned first;
+	unsigned size;
+
+	bool IsFull() const { return size == queueSize; }
+
+	void Push(const Request& request)
+	{
+		requests[(first + size++) % queueSize] = request;
+	}
+
+	Request Pop()
+	{
+		const Request& res = requests[first];
+		first = (first + 1) % queueSize;
+		size--;
+
+		return res;
+	}
+};
+
+// Immediate spawns don't have a queue
+static constinit std::array<Queue, SpawnQueue::NUM_PRIORITIES - SpawnQueue::HIGH> queues = {};
+
+static void Spawn(const Request& request)
+{
+	Actor* actor = nullptr;
+
+	// Requests from a previous level are dropped
+	if (request.levelID == static_cast<uint8_t>(LEVEL_ID))
+	{
+		actor = Actor::Spawn(
+			request.actorID, request.param1, request.pos,
+			request.hasAng ? &request.ang : nullptr, request.areaID, request.deathTableID
+		);
+	}
+
+	if (request.callback)
+		request.callback(actor, request.userData);
+}
+
+void SpawnQueue::Push(
+	unsigned actorID, unsigned param1, const Vector3& pos, const Vector3_16* ang, int areaID, int deathTableID,
+	Priority priority, Callback callback, void* userData
+)
+{
+	const Request request =
+	{
+		.pos          = pos,
+		.ang          = ang ? *ang : Vector3_16{},
+		.hasAng       = ang != nullptr,
+		.levelID      = static_cast<uint8_t>(LEVEL_ID),
+		.actorID      = static_cast<uint16_t>(actorID),
+		.areaID       = static_cast<int8_t>(areaID),
+		.param1       = param1,
+		.deathTableID = deathTableID,
+		.callback     = callback,
+		.userData     = userData,
+	};
+
+	if (priority == IMMEDIATE || queues[priority - HIGH].IsFull())
+		Spawn(request);
+	else
+		queues[priority - HIGH].Push(request);
+}
+
+void SpawnQueue::Cancel(const void* userData)
+{
+	for (Queue& queue : queues)
+	{
+		unsigned numKept = 0;
+
+		for (unsigned i = 0; i < queue.size; i++)
+		{
+			const Request& request = queue.requests[(queue.first + i) % queueSize];
+
+			if (request.userData != userData)
+				queue.requests[(queue.first + numKept++) % queueSize] = request;
+		}
+
+		queue.size = numKept;
+	}
+}
+
+unsigned SpawnQueue::NumPending()
+{
+	unsigned res = 0;
+
+	for (const Queue& queue : queues)
+		res += queue.size;
+
+	return res;
+}
+
+static Queue* FirstNonEmptyQueue()
+{
+	for (Queue& queue : queues)
+		if (queue.size != 0) return &queue;
+
+	return nullptr;
+}
+
+void SpawnQueue::Update()
+{
+	Queue* queue = FirstNonEmptyQueue();
+
+	if (!queue) [[likely]]
+		return;
+
+	HWTimer::Start();
+	const unsigned start = HWTimer::Read();
+
+	for (unsigned numSpawned = 0; queue && numSpawned < maxSpawnsPerFrame; numSpawned++)
+	{
+		if (numSpawned != 0 && HWTimer::TicksToCycles(HWTimer::Read() - start) >= cycleBudget)
+			return;
+
+		// The callback may push new requests, so the request is
+		// removed from the queue before the actor is spawned
+		Spawn(queue->Pop());
+
+		queue = FirstNonEmptyQueue();
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef SPAWN_QUEUE_INCLUDED
+#define SPAWN_QUEUE_INCLUDED
+
+#include "SM64DS_PI.h"
+
+// Spreads actor spawns over several frames, so that spawning a lot of actors at
+// once doesn't cause a lag spike. Each frame, queued spawns are done in order of
+// priority until either the time budget or the count budget runs out. At least
+// one spawn is done per frame, so the queue can't stall.
+namespace SpawnQueue
+{
+	enum Priority : uint8_t
+	{
+		IMMEDIATE, // bypasses the queue
+		HIGH,
+		NORMAL,
+		LOW,
+
+		NUM_PRIORITIES
+	};
+
+	// Called with the spawned actor, or nullptr if the spawn failed
+	// or the level changed before the request was processed
+	using Callback = void(*)(Actor* actor, void* userData);
+
+	constexpr unsigned maxSpawnsPerFrame = 4;
+	constexpr unsigned cycleBudget = 33'000; // about 3% of a frame at 60 fps, which is 1.12M cycles
+
+	// Queues a spawn with the same arguments as Actor::Spawn. If the queue for the
+	// given priority is full, the actor is spawned immediately, so no request is lost.
+	void Push(
+		unsigned actorID, unsigned param1, const Vector3& pos, const Vector3_16* ang, int areaID, int deathTableID,
+		Priority priority = NORMAL, Callback callback = nullptr, void* userData = nullptr
+	);
+
+	// Drops the pending requests with the given user data without calling their
+	// callbacks. Actors that queue spawns for themselves should call this when
+	// they are destroyed.
+	void Cancel(const void* userData);
+
+	unsigned NumPending();
+
+	// Called once per frame from frame_hook.cpp
+	void Update();
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "SM64DS_PI.h"
 #include <cstring>
+#include <memory>
 #include <tuple>
 
 template<class T> concept UnalignedReadable =
@@ -39,10 +40,29 @@ namespace UnalignedImpl
 		return {Read<Underlying<T>>(ptr), as_raw};
 	}
 
+	// Used when ptr is known to be aligned for T, so that
+	// the copy compiles to a single ldr, ldrh or ldrb
+	template<class T> [[gnu::always_inline]]
+	inline T ReadDirect(const char* ptr)
+	{
+		static_assert(UnalignedReadable<T>);
+
+		T res;
+		std::memcpy(&res, std::assume_aligned<alignof(T)>(ptr), sizeof(res));
+
+		return res;
+	}
+
+	constexpr std::size_t AlignUp(std::size_t offset, std::size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Offsets of tightly packed values
 	template<class... Types>
 	constexpr auto offsets = []
 	{
-		auto offsets = std::to_array<std::size_t>({sizeof(Types)...});
+		std::array<std::size_t, sizeof...(Types)> offsets = {sizeof(Types)...};
 
 		for (std::size_t nextOffset = 0; std::size_t& offset : offsets)
 			nextOffset += std::exchange(offset, nextOffset);
@@ -50,6 +70,32 @@ namespace UnalignedImpl
 		return offsets;
 	}();
 
+	// Offsets of values that are each aligned like they would be in a struct
+	template<class... Types>
+	constexpr auto alignedOffsets = []
+	{
+		constexpr std::array<std::size_t, sizeof...(Types)> sizes = {sizeof(Types)...};
+		std::array<std::size_t, sizeof...(Types)> offsets = {alignof(Types)...};
+
+		for (std::size_t nextOffset = 0, i = 0; std::size_t& offset : offsets)
+		{
+			offset = AlignUp(nextOffset, offset);
+			nextOffset = offset + sizes[i++];
+		}
+
+		return offsets;
+	}();
+
+	template<bool aligned, class... Types>
+	constexpr const auto& layoutOffsets = aligned ? alignedOffsets<Types...> : offsets<Types...>;
+
+	template<bool aligned, class... Types>
+	constexpr std::size_t layoutSize = 0;
+
+	template<bool aligned, class... Types> requires (sizeof...(Types) > 0)
+	constexpr std::size_t layoutSize<aligned, Types...> =
+		layoutOffsets<aligned, Types...>.back() + std::to_array({sizeof(Types)...}).back();
+
 	template<class T> concept Vector =
 		std::same_as<T, Vector3> ||
 		std::same_as<T, Vector3_16> ||
@@ -66,13 +112,17 @@ namespace UnalignedImpl
 	template<std::size_t i, class T>
 	using VectorElemType = decltype(auto(GetVectorElem<i>(std::declval<T>())));
 
-	template<Vector T>
+	template<Vector T, bool aligned = false>
 	inline void ReadVector(const char* ptr, Vector3& res)
 	{
 		[&]<std::size_t... i>[[gnu::always_inline]](std::index_sequence<i...>)
 		{
-			((GetVectorElem<i>(res) = Read<VectorElemType<i, T>>
-			(ptr + offsets<VectorElemType<i, T>...>[i])), ...);
+			constexpr auto& elemOffsets = offsets<VectorElemType<i, T>...>;
+
+			if constexpr (aligned)
+				((GetVectorElem<i>(res) = ReadDirect<VectorElemType<i, T>>(ptr + elemOffsets[i])), ...);
+			else
+				((GetVectorElem<i>(res) = Read<VectorElemType<i, T>>(ptr + elemOffsets[i])), ...);
 		}
 		(std::make_index_sequence<3>());
 	}
@@ -86,39 +136,83 @@ namespace UnalignedImpl
 		});
 	}
 
+	template<Vector T> [[gnu::always_inline]]
+	inline auto ReadDirect(const char* ptr)
+	{
+		return Vector3::Proxy([ptr]<bool resMayAlias> [[gnu::always_inline]] (Vector3& res)
+		{
+			ReadVector<T, true>(ptr, res);
+		});
+	}
+
+	template<bool aligned, class T> [[gnu::always_inline]]
+	inline auto ReadAs(const char* ptr)
+	{
+		if constexpr (aligned)
+			return ReadDirect<T>(ptr);
+		else
+			return Read<T>(ptr);
+	}
+
 	template<UnalignedReadable T>
 	using ReadResult = decltype(Read<T>(std::declval<const char*>()));
 
-	template<class... Types> [[gnu::always_inline]]
+	template<bool aligned, class... Types> [[gnu::always_inline]]
 	inline decltype(auto) Visit(const char* ptr, auto&& f)
 	{
 		return [&]<std::size_t... i>[[gnu::always_inline]](std::index_sequence<i...>) -> decltype(auto)
 		{
-			return f(Read<Types>(ptr + offsets<Types...>[i])...);
+			return f(ReadAs<aligned, Types>(ptr + layoutOffsets<aligned, Types...>[i])...);
 		}
 		(std::make_index_sequence<sizeof...(Types)>());
 	}
+
+	template<bool aligned, UnalignedReadable... Types> [[gnu::always_inline]]
+	inline auto ReadLayout(const char* ptr)
+	{
+		if constexpr (sizeof...(Types) == 1)
+			return ReadAs<aligned, Types...>(ptr);
+		else
+			return Visit<aligned, Types...>(ptr, std::make_tuple<ReadResult<Types>...>);
+	}
+
+	template<bool aligned, class F> [[gnu::always_inline]]
+	inline decltype(auto) VisitLayout(const char* ptr, F&& f)
+	{
+		using Lambda = std::remove_cvref_t<F>;
+
+		return [&]<class R, class... Args>[[gnu::always_inline]](R(Lambda::*)(Args...) const) -> R
+		{
+			return Visit<aligned, Args...>(ptr, f);
+		}
+		(&Lambda::operator());
+	}
 };
 
 template<UnalignedReadable... Types> [[gnu::always_inline, nodiscard]]
 inline auto ReadUnaligned(const char* ptr)
 {
-	using namespace UnalignedImpl;
-
-	if constexpr (sizeof...(Types) == 1)
-		return Read<Types...>(ptr);
-	else
-		return Visit<Types...>(ptr, std::make_tuple<ReadResult<Types>...>);
+	return UnalignedImpl::ReadLayout<false, Types...>(ptr);
 }
 
 template<class F> [[gnu::always_inline]]
 inline decltype(auto) VisitUnaligned(const char* ptr, F&& f)
 {
-	return [&]<class R, class... Args>[[gnu::always_inline]](R(F::*)(Args...) const) -> R
-	{
-		return UnalignedImpl::Visit<Args...>(ptr, f);
-	}
-	(&F::operator());
+	return UnalignedImpl::VisitLayout<false>(ptr, std::forward<F>(f));
+}
+
+// Like ReadUnaligned, but ptr must be word-aligned and each value must be
+// at an offset that's a multiple of its own alignment, as in a struct
+template<UnalignedReadable... Types> [[gnu::always_inline, nodiscard]]
+inline auto ReadAligned(const char* ptr)
+{
+	return UnalignedImpl::ReadLayout<true, Types...>(ptr);
+}
+
+template<class F> [[gnu::always_inline]]
+inline decltype(auto) VisitAligned(const char* ptr, F&& f)
+{
+	return UnalignedImpl::VisitLayout<true>(ptr, std::forward<F>(f));
 }
 
-#endif
\ No newline at end of file
+#endif
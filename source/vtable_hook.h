@@ -0,0 +1,80 @@
+#ifndef VTABLE_HOOK_INCLUDED
+#define VTABLE_HOOK_INCLUDED
+
+#include "SM64DS_PI.h"
+#include <array>
+#include <bit>
+#include <cstring>
+
+// Replaces a virtual function of actor classes in their vtables, for code that
+// has to run around it for every class, where the game has no single place that
+// could be hooked. A Table remembers the original function of each vtable.
+namespace VTableHook
+{
+	// On ARM, a pointer to a virtual member function holds its offset
+	// in the vtable and has the lowest bit of the adjustment set
+	template<class Func>
+	unsigned IndexOf(Func func)
+	{
+		struct { uintptr_t ptr; ptrdiff_t adj; } repr;
+		static_assert(sizeof(repr) == sizeof(func));
+
+		std::memcpy(&repr, &func, sizeof(func));
+		if (!(repr.adj & 1)) Crash();
+
+		return repr.ptr / sizeof(void*);
+	}
+
+	inline void** VTableOf(const ActorBase& actor)
+	{
+		return *reinterpret_cast<void** const*>(&actor);
+	}
+
+	template<class Func, unsigned size> requires (std::has_single_bit(size))
+	struct Table
+	{
+		struct Entry
+		{
+			void** vtable;
+			Func original;
+		};
+
+		std::array<Entry, size> entries;
+
+		// Returns the entry of the vtable, or a free one, or nullptr if the table is full
+		Entry* Find(void** vtable)
+		{
+			const uintptr_t addr = reinterpret_cast<uintptr_t>(vtable);
+
+			for (unsigned i = (addr >> 2) * 2654435761u >> (32 - std::countr_zero(size)), n = 0; n < size; i = (i + 1) % size, n++)
+				if (entries[i].vtable == vtable || !entries[i].vtable)
+					return &entries[i];
+
+			return nullptr;
+		}
+
+		// Puts the wrapper into the vtable of the class of the actor at the given
+		// index, unless it's already there or the table is full. The vtables of a
+		// DL or an overlay that was loaded again aren't wrapped anymore, so their
+		// entry is updated with the function of the new code.
+		void Wrap(const ActorBase& actor, unsigned index, Func wrapper)
+		{
+			void** const vtable = VTableOf(actor);
+			if (vtable[index] == reinterpret_cast<void*>(wrapper)) return;
+
+			Entry* const entry = Find(vtable);
+			if (!entry) return;
+
+			*entry = {vtable, reinterpret_cast<Func>(vtable[index])};
+			vtable[index] = reinterpret_cast<void*>(wrapper);
+		}
+
+		// Only for actors whose class was wrapped, which is the case in the wrapper
+		Func OriginalOf(const ActorBase& actor)
+		{
+			return Find(VTableOf(actor))->original;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include "warp_pipe_table.h"
+#include <algorithm>
+#include <array>
+
+// Add the actor IDs of custom pipes here
+constexpr std::array<uint16_t, 1> warpPipeIDs = {298};
+
+constexpr Fix12i maxPipeDist = 300._f;
+constexpr unsigned maxPipes = 16;
+
+enum class CachedResult : uint8_t { UNKNOWN, FAR, NEAR };
+
+static constinit std::array<const Actor*, maxPipes> pipes = {};
+static constinit unsigned numPipes = 0;
+static constinit unsigned numExistingPipes = 0;
+
+// Set if there were too many pipes to keep track of, in which
+// case all actors are searched until every pipe is gone
+static constinit bool overflow = false;
+
+// Cleared every time a pipe spawns or despawns. The results don't depend
+// on the level as long as the set of pipes stays the same.
+static constinit std::array<CachedResult, 0x100> entranceResults = {};
+
+static bool IsWarpPipe(const Actor& actor)
+{
+	return std::ranges::find(warpPipeIDs, actor.actorID) != warpPipeIDs.end();
+}
+
+static bool SearchActors(const Vector3& pos)
+{
+	for (uint16_t actorID : warpPipeIDs)
+	{
+		Actor* pipe = nullptr;
+
+		while ((pipe = Actor::FindWithActorID(actorID, pipe)))
+			if (pipe->pos.Dist(pos) < maxPipeDist) return true;
+	}
+
+	return false;
+}
+
+bool WarpPipeTable::IsNearPipe(const Vector3& pos)
+{
+	if (overflow) [[unlikely]]
+		return SearchActors(pos);
+
+	return std::any_of(pipes.begin(), pipes.begin() + numPipes, [&pos](const Actor* pipe)
+	{
+		return pipe->pos.Dist(pos) < maxPipeDist;
+	});
+}
+
+bool WarpPipeTable::IsEntranceNearPipe(unsigned entranceID)
+{
+	CachedResult& result = entranceResults[entranceID & 0xff];
+
+	if (result == CachedResult::UNKNOWN)
+		result = IsNearPipe(ENTRANCE_ARR_PTR[entranceID].pos) ? CachedResult::NEAR : CachedResult::FAR;
+
+	return result == CachedResult::NEAR;
+}
+
+void WarpPipeTable::OnActorConstructed(const Actor& actor)
+{
+	if (!IsWarpPipe(actor)) [[likely]]
+		return;
+
+	numExistingPipes++;
+
+	if (numPipes < maxPipes)
+		pipes[numPipes++] = &actor;
+	else
+		overflow = true;
+
+	entranceResults.fill(CachedResult::UNKNOWN);
+}
+
+void WarpPipeTable::OnActorDestructed(const Actor& actor)
+{
+	if (!IsWarpPipe(actor)) [[likely]]
+		return;
+
+	const auto end = pipes.begin() + numPipes;
+	const auto it = std::find(pipes.begin(), end, &actor);
+
+	if (it != end)
+	{
+		*it = *(end - 1);
+		numPipes--;
+	}
+
+	if (--numExistingPipes == 0)
+		overflow = false;
+
+	entranceResults.fill(CachedResult::UNKNOWN);
+}
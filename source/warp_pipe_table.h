@@ -0,0 +1,18 @@
+#ifndef WARP_PIPE_TABLE_INCLUDED
+#define WARP_PIPE_TABLE_INCLUDED
+
+#include "SM64DS_PI.h"
+
+// Keeps track of the warp pipes in the level, so that checking whether an exit
+// or an entrance is next to one doesn't require searching through all actors.
+namespace WarpPipeTable
+{
+	bool IsNearPipe(const Vector3& pos);
+	bool IsEntranceNearPipe(unsigned entranceID);
+
+	// Called by the actor extension hooks in actor_extension.cpp
+	void OnActorConstructed(const Actor& actor);
+	void OnActorDestructed(const Actor& actor);
+}
+
+#endif
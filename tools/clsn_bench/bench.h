@@ -0,0 +1,21 @@
+#ifndef CLSN_BENCH_INCLUDED
+#define CLSN_BENCH_INCLUDED
+
+#include "SM64DS_PI.h"
+#include <map>
+#include <vector>
+
+namespace Bench
+{
+	extern std::vector<MeshColliderBase*> colliders; // the enabled ones, in the order they were enabled
+	extern std::map<unsigned, std::vector<char>> files; // by overlay 0 file ID
+	extern CLPS clpsTable[0x100];
+}
+
+// The entry points of the DLs in COLLIDER_DLS, which the Makefile renames
+// to <name>_init and <name>_cleanup so that they can be linked together
+#define X(name) void name##_init(); void name##_cleanup();
+COLLIDER_DLS
+#undef X
+
+#endif
@@ -0,0 +1,509 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Replays a stream of collision queries against the colliders of the DLs in
+// COLLIDER_DLS the way the game does, by asking every enabled collider in the
+// order they were enabled. The results can be written to a golden file or
+// compared to one, so that optimizations of the colliders can be checked for
+// changes in gameplay, and the time the queries take is reported.
+//
+// A stream is a text file with one command per line, and all positions and
+// sizes are raw Fix12i values:
+//
+//   spawn ACTOR_ID PARAM1 X Y Z ANG_X ANG_Y ANG_Z
+//   file OV0_FILE_ID HEX_BYTES          (loaded by SharedFilePtr)
+//   frame                               (calls BeforeBehavior of every actor)
+//   ground X Y Z MASK
+//   line X0 Y0 Z0 X1 Y1 Z1 MASK
+//   sphere X Y Z RADIUS MASK
+//
+// MASK is the set of CLPS bits the query passes through, see include/SM64DS_PI.h.
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum QueryType { GROUND, LINE, SPHERE, NUM_QUERY_TYPES };
+
+	constexpr const char* queryNames[NUM_QUERY_TYPES] = {"ground", "line", "sphere"};
+
+	struct Command
+	{
+		enum Type { SPAWN, FRAME, QUERY };
+
+		Type type;
+		QueryType queryType;
+		std::array<int, 8> args;
+		unsigned lineID;
+	};
+
+	[[noreturn]] void Fail(const std::string& message)
+	{
+		std::fprintf(stderr, "error: %s\n", message.c_str());
+		std::exit(2);
+	}
+
+	/* -------- -------- Streams -------- -------- */
+
+	std::vector<char> ParseHex(std::string_view hex)
+	{
+		if (hex.size() % 2) Fail("odd number of hex digits");
+
+		std::vector<char> res(hex.size() / 2);
+
+		for (std::size_t i = 0; i < res.size(); i++)
+			res[i] = static_cast<char>(std::stoi(std::string(hex.substr(2 * i, 2)), nullptr, 16));
+
+		return res;
+	}
+
+	std::vector<Command> ReadStream(const char* path)
+	{
+		std::ifstream file(path);
+		if (!file) Fail(std::string("can't open ") + path);
+
+		std::vector<Command> res;
+		std::string line;
+
+		for (unsigned lineID = 1; std::getline(file, line); lineID++)
+		{
+			std::istringstream in(line);
+			std::string name;
+
+			if (!(in >> name) || name[0] == '#') continue;
+
+			if (name == "file")
+			{
+				unsigned fileID;
+				std::string hex;
+
+				if (!(in >> fileID >> hex)) Fail("malformed file command on line " + std::to_string(lineID));
+
+				Bench::files[fileID] = ParseHex(hex);
+				continue;
+			}
+
+			Command cmd = {.lineID = lineID};
+			unsigned numArgs;
+
+			if      (name == "spawn")  { cmd.type = Command::SPAWN; numArgs = 8; }
+			else if (name == "frame")  { cmd.type = Command::FRAME; numArgs = 0; }
+			else if (name == "ground") { cmd.type = Command::QUERY; cmd.queryType = GROUND; numArgs = 4; }
+			else if (name == "line")   { cmd.type = Command::QUERY; cmd.queryType = LINE;   numArgs = 7; }
+			else if (name == "sphere") { cmd.type = Command::QUERY; cmd.queryType = SPHERE; numArgs = 5; }
+			else Fail("unknown command " + name + " on line " + std::to_string(lineID));
+
+			for (unsigned i = 0; i < numArgs; i++)
+				if (!(in >> cmd.args[i])) Fail("missing value on line " + std::to_string(lineID));
+
+			res.push_back(cmd);
+		}
+
+		return res;
+	}
+
+	// Writes a stream of random queries around a scene with a few colliders of every kind
+	void GenerateStream(const char* path, unsigned numQueries, unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		auto rand = [&rng](int min, int max) { return std::uniform_int_distribution(min, max)(rng); };
+		auto raw = [](int units) { return units << 12; };
+
+		std::ofstream out(path);
+		if (!out) Fail(std::string("can't write ") + path);
+
+		out << "# Generated by clsn_bench --generate " << path << " --queries " << numQueries << " --seed " << seed << '\n';
+
+		std::vector<std::array<int, 3>> positions;
+
+		auto spawn = [&](unsigned actorID, unsigned param1, int x, int y, int z, int angX, int angZ)
+		{
+			out << "spawn " << actorID << ' ' << param1 << ' ' << raw(x) << ' ' << raw(y) << ' ' << raw(z)
+				<< ' ' << angX << " 0 " << angZ << '\n';
+
+			positions.push_back({x, y, z});
+		};
+
+		spawn(562, 1, 0, -2000, 0, 0, 0); // InfiniteFloor
+
+		// The analytic colliders, 563 to 567
+		for (unsigned i = 0; i < 20; i++)
+		{
+			const unsigned actorID = 563 + i % 5;
+			unsigned param1 = rand(0, 7) | rand(0, 15) << 8;
+
+			if (actorID == 564) param1 = rand(0, 7) | (rand(-20, 20) & 0xff) << 8; // the rise of a slope
+			if (actorID == 567) param1 = rand(0, 7) | rand(0, 2) << 8 | rand(1, 20) << 10; // axis and distance of a platform
+
+			spawn(actorID, param1, rand(-5000, 5000), rand(-500, 500), rand(-5000, 5000), rand(50, 400), rand(50, 400));
+		}
+
+		// A heightfield of 16 x 16 cells of 200 units, whose heights go up to 400 units
+		constexpr unsigned numCells = 16;
+		constexpr unsigned heightShift = 6;
+
+		std::vector<uint8_t> hfld;
+		auto append = [&hfld](auto val, unsigned size) { for (unsigned i = 0; i < size; i++) hfld.push_back(val >> 8 * i); };
+
+		append(0x444c4648u, 4);
+		append(numCells, 2);
+		append(numCells, 2);
+		append(raw(200), 4);
+		append(heightShift, 1);
+		append(0, 3);
+
+		for (unsigned i = 0; i < (numCells + 1) * (numCells + 1); i++)
+			append(raw(rand(0, 400)) >> heightShift, 2);
+
+		for (unsigned i = 0; i < numCells * numCells; i++)
+			append(rand(0, 7), 1);
+
+		out << "file 1 ";
+		for (uint8_t byte : hfld) out << "0123456789abcdef"[byte >> 4] << "0123456789abcdef"[byte & 15];
+		out << '\n';
+
+		spawn(568, 1, -1600, -800, -1600, 0, 0);
+
+		// Half of the queries are close to a collider, and some repeat the last position
+		// like actors that stand still
+		std::array<int, 3> pos = {};
+
+		for (unsigned i = 0; i < numQueries; i++)
+		{
+			if (i % 16 == 15) out << "frame\n";
+
+			if (rand(0, 2) != 0)
+			{
+				if (rand(0, 1))
+				{
+					const auto& center = positions[rand(0, positions.size() - 1)];
+					pos = {center[0] + rand(-500, 500), center[1] + rand(-200, 600), center[2] + rand(-500, 500)};
+				}
+				else
+					pos = {rand(-6000, 6000), rand(-2500, 1500), rand(-6000, 6000)};
+			}
+
+			const unsigned mask = rand(0, 3) == 0 ? rand(0, 0xff) : 0;
+			const int type = rand(0, 3);
+
+			if (type <= 1)
+				out << "ground " << raw(pos[0]) << ' ' << raw(pos[1]) << ' ' << raw(pos[2]) << ' ' << mask << '\n';
+			else if (type == 2)
+			{
+				out << "line " << raw(pos[0]) << ' ' << raw(pos[1]) << ' ' << raw(pos[2]) << ' '
+					<< raw(pos[0] + rand(-1500, 1500)) << ' ' << raw(pos[1] + rand(-2000, 500)) << ' '
+					<< raw(pos[2] + rand(-1500, 1500)) << ' ' << mask << '\n';
+			}
+			else
+				out << "sphere " << raw(pos[0]) << ' ' << raw(pos[1]) << ' ' << raw(pos[2]) << ' ' << raw(rand(20, 150)) << ' ' << mask << '\n';
+		}
+	}
+
+	/* -------- -------- Replay -------- -------- */
+
+	Vector3 VectorArg(const Command& cmd, unsigned first)
+	{
+		return {{cmd.args[first], as_raw}, {cmd.args[first + 1], as_raw}, {cmd.args[first + 2], as_raw}};
+	}
+
+	std::string ToString(const Vector3& v)
+	{
+		return std::to_string(v.x.val) + ',' + std::to_string(v.y.val) + ',' + std::to_string(v.z.val);
+	}
+
+	std::string ToString(const SurfaceInfo& info)
+	{
+		return " normal=" + ToString(info.normal) + " clps=" + std::to_string(info.clps.high);
+	}
+
+	template<class Query>
+	void Detect(Query& query)
+	{
+		for (MeshColliderBase* collider : Bench::colliders)
+			collider->DetectClsn(query);
+	}
+
+	// Returns a description of the result if asked to
+	std::string RunQuery(const Command& cmd, bool describe)
+	{
+		const unsigned mask = cmd.args[cmd.queryType == GROUND ? 3 : cmd.queryType == LINE ? 6 : 4];
+
+		switch (cmd.queryType)
+		{
+		case GROUND:
+		{
+			RaycastGround ray;
+			ray.passThroughMask = mask;
+			ray.pos = VectorArg(cmd, 0);
+
+			Detect(ray);
+
+			if (!describe || !ray.hadCollision) return describe ? "no hit" : "";
+			return "hit y=" + std::to_string(ray.clsnPosY.val) + ToString(ray.result.surfaceInfo);
+		}
+		case LINE:
+		{
+			RaycastLine ray;
+			ray.passThroughMask = mask;
+			ray.line = {VectorArg(cmd, 0), VectorArg(cmd, 3)};
+
+			Detect(ray);
+
+			if (!describe || !ray.hadCollision) return describe ? "no hit" : "";
+			return "hit pos=" + ToString(ray.clsnPos) + ToString(ray.result.surfaceInfo);
+		}
+		default:
+		{
+			SphereClsn sphere;
+			sphere.passThroughMask = mask;
+			sphere.pos = VectorArg(cmd, 0);
+			sphere.radius = {cmd.args[3], as_raw};
+
+			Detect(sphere);
+
+			if (!describe || !sphere.resultFlags) return describe ? "no hit" : "";
+
+			std::string res = "flags=" + std::to_string(sphere.resultFlags)
+				+ " pushback0=" + ToString(sphere.pushback0) + " pushback1=" + ToString(sphere.pushback1);
+
+			if (sphere.resultFlags & SphereClsn::ON_GROUND)
+				res += " floor" + ToString(sphere.floorResult.surfaceInfo);
+
+			return res;
+		}
+		}
+	}
+
+	struct Stats
+	{
+		unsigned long count = 0;
+		Clock::duration total = {};
+	};
+
+	struct Results
+	{
+		std::vector<std::string> descriptions; // one for each query
+		std::vector<unsigned> lineIDs;
+		std::array<Stats, NUM_QUERY_TYPES> stats;
+	};
+
+	void Replay(const std::vector<Command>& commands, Results& results, bool describe)
+	{
+		std::vector<Actor*> actors;
+
+		for (const Command& cmd : commands)
+		{
+			switch (cmd.type)
+			{
+			case Command::SPAWN:
+			{
+				const SpawnInfo* spawnInfo = ACTOR_SPAWN_TABLE[cmd.args[0] & 0x3ff];
+				if (!spawnInfo) Fail("actor " + std::to_string(cmd.args[0]) + " isn't in any DL");
+
+				Actor* actor = static_cast<Actor*>(spawnInfo->spawnFunc());
+				actor->actorID = cmd.args[0];
+				actor->param1 = cmd.args[1];
+				actor->pos = VectorArg(cmd, 2);
+				actor->ang = {static_cast<short>(cmd.args[5]), static_cast<short>(cmd.args[6]), static_cast<short>(cmd.args[7])};
+				actor->InitResources();
+
+				actors.push_back(actor);
+				break;
+			}
+			case Command::FRAME:
+				for (Actor* actor : actors)
+					actor->BeforeBehavior();
+
+				break;
+
+			case Command::QUERY:
+			{
+				const auto start = Clock::now();
+				std::string description = RunQuery(cmd, describe);
+				const auto time = Clock::now() - start;
+
+				Stats& stats = results.stats[cmd.queryType];
+				stats.count++;
+				stats.total += time;
+
+				if (describe)
+				{
+					results.descriptions.push_back(std::move(description));
+					results.lineIDs.push_back(cmd.lineID);
+				}
+
+				break;
+			}
+			}
+		}
+
+		for (Actor* actor : actors)
+		{
+			actor->CleanupResources();
+			delete actor;
+		}
+	}
+
+	/* -------- -------- Reports -------- -------- */
+
+	void PrintStats(const Results& results, unsigned numIterations)
+	{
+		using namespace std::chrono;
+
+		std::puts("  query        count   total [us]   avg [ns]   queries/s");
+
+		Stats all;
+
+		for (unsigned type = 0; type < NUM_QUERY_TYPES; type++)
+		{
+			const Stats& stats = results.stats[type];
+			if (stats.count == 0) continue;
+
+			const double total = duration<double>(stats.total).count();
+
+			std::printf("  %-6s   %9lu   %10.1f   %8.1f   %9.0f\n", queryNames[type], stats.count / numIterations,
+				total * 1e6 / numIterations, total * 1e9 / stats.count, stats.count / total);
+
+			all.count += stats.count;
+			all.total += stats.total;
+		}
+
+		const double total = duration<double>(all.total).count();
+
+		std::printf("  %-6s   %9lu   %10.1f   %8.1f   %9.0f\n\n", "all", all.count / numIterations,
+			total * 1e6 / numIterations, total * 1e9 / all.count, all.count / total);
+	}
+
+	// Returns the number of queries whose results differ
+	unsigned Compare(const char* path, const Results& results)
+	{
+		std::ifstream file(path);
+		if (!file) Fail(std::string("can't open ") + path);
+
+		std::vector<std::string> expected;
+		for (std::string line; std::getline(file, line);)
+			expected.push_back(line);
+
+		if (expected.size() != results.descriptions.size())
+		{
+			std::printf("%s has %zu results, but the stream has %zu queries\n", path, expected.size(), results.descriptions.size());
+			return std::max(expected.size(), results.descriptions.size());
+		}
+
+		unsigned numDiffs = 0;
+
+		for (std::size_t i = 0; i < expected.size(); i++)
+		{
+			if (expected[i] == results.descriptions[i]) continue;
+
+			if (numDiffs++ < 10)
+				std::printf("Query on line %u of the stream:\n  expected %s\n  got      %s\n",
+					results.lineIDs[i], expected[i].c_str(), results.descriptions[i].c_str());
+		}
+
+		return numDiffs;
+	}
+
+	[[noreturn]] void Usage(const char* name)
+	{
+		std::fprintf(stderr,
+			"Usage: %s STREAM [options]\n"
+			"       %s --generate STREAM [--queries N] [--seed N]\n"
+			"  --golden FILE      write the result of each query to FILE\n"
+			"  --compare FILE     compare the results to a golden file, and fail if they differ\n"
+			"  --iterations N     replay the stream N times and average the timings (default: 1)\n"
+			"  --generate STREAM  write a stream of random queries around a scene of colliders\n"
+			"  --queries N        number of queries to generate (default: 1000)\n"
+			"  --seed N           seed of the generated queries (default: 1)\n",
+			name, name);
+
+		std::exit(2);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* streamPath = nullptr;
+	const char* goldenPath = nullptr;
+	const char* comparePath = nullptr;
+	const char* generatePath = nullptr;
+	unsigned numIterations = 1;
+	unsigned numQueries = 1000;
+	unsigned seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+
+		if (!arg.starts_with("--"))
+		{
+			if (streamPath) Usage(argv[0]);
+			streamPath = argv[i];
+			continue;
+		}
+
+		if (i + 1 == argc) Usage(argv[0]);
+
+		if      (arg == "--golden")     goldenPath    = argv[++i];
+		else if (arg == "--compare")    comparePath   = argv[++i];
+		else if (arg == "--iterations") numIterations = std::max(std::atoi(argv[++i]), 1);
+		else if (arg == "--generate")   generatePath  = argv[++i];
+		else if (arg == "--queries")    numQueries    = std::atoi(argv[++i]);
+		else if (arg == "--seed")       seed          = std::atoi(argv[++i]);
+		else Usage(argv[0]);
+	}
+
+	if (generatePath)
+	{
+		GenerateStream(generatePath, numQueries, seed);
+		return 0;
+	}
+
+	if (!streamPath) Usage(argv[0]);
+
+	#define X(name) name##_init();
+	COLLIDER_DLS
+	#undef X
+
+	const std::vector<Command> commands = ReadStream(streamPath);
+	Results results;
+
+	for (unsigned iteration = 0; iteration < numIterations; iteration++)
+		Replay(commands, results, iteration == 0);
+
+	#define X(name) name##_cleanup();
+	COLLIDER_DLS
+	#undef X
+
+	std::printf("%zu queries, %u iteration(s)\n\n", results.descriptions.size(), numIterations);
+	PrintStats(results, numIterations);
+
+	if (goldenPath)
+	{
+		std::ofstream out(goldenPath);
+
+		for (const std::string& description : results.descriptions)
+			out << description << '\n';
+	}
+
+	if (comparePath)
+	{
+		if (const unsigned numDiffs = Compare(comparePath, results))
+		{
+			std::fprintf(stderr, "%u result(s) differ from %s\n", numDiffs, comparePath);
+			return 1;
+		}
+
+		std::printf("All results match %s\n", comparePath);
+	}
+
+	return 0;
+}
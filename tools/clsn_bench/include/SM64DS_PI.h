@@ -0,0 +1,226 @@
+#ifndef SM64DS_PI_MOCK_INCLUDED
+#define SM64DS_PI_MOCK_INCLUDED
+
+// A host-side stand-in for the parts of SM64DS-PI used by the collider DLs.
+// Enabled colliders are kept in a list that the benchmark queries in order, like
+// the game does, and the filter of a query is a mask of CLPS bits to pass through.
+
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/* -------- -------- Fixed point -------- -------- */
+
+struct AsRaw {};
+constexpr AsRaw as_raw;
+
+struct Fix12i
+{
+	int val;
+
+	constexpr Fix12i() = default;
+	constexpr Fix12i(int val, AsRaw): val(val) {}
+
+	constexpr Fix12i operator-() const { return {-val, as_raw}; }
+
+	constexpr Fix12i operator+(Fix12i other) const { return {val + other.val, as_raw}; }
+	constexpr Fix12i operator-(Fix12i other) const { return {val - other.val, as_raw}; }
+
+	constexpr Fix12i operator*(Fix12i other) const
+	{
+		return {static_cast<int>((static_cast<int64_t>(val) * other.val + 0x800) >> 12), as_raw};
+	}
+
+	constexpr Fix12i operator/(Fix12i other) const
+	{
+		return {static_cast<int>((static_cast<int64_t>(val) << 12) / other.val), as_raw};
+	}
+
+	constexpr Fix12i operator>>(int shift) const { return {val >> shift, as_raw}; }
+	constexpr Fix12i operator<<(int shift) const { return {val << shift, as_raw}; }
+
+	constexpr Fix12i& operator+=(Fix12i other) { return *this = *this + other; }
+	constexpr Fix12i& operator-=(Fix12i other) { return *this = *this - other; }
+
+	constexpr auto operator<=>(const Fix12i&) const = default;
+
+	explicit constexpr operator double() const { return val / 4096.0; }
+};
+
+consteval Fix12i operator""_f(unsigned long long val) { return {static_cast<int>(val), as_raw}; }
+consteval Fix12i operator""_f(long double val) { return {static_cast<int>(val * 4096), as_raw}; }
+
+inline Fix12i Abs(Fix12i x) { return x.val < 0 ? -x : x; }
+
+/* -------- -------- Vectors -------- -------- */
+
+struct Vector3_16
+{
+	short x, y, z;
+};
+
+struct Vector3
+{
+	Fix12i x, y, z;
+
+	static Vector3 Temp(Fix12i x, Fix12i y, Fix12i z) { return {x, y, z}; }
+
+	Vector3 operator+(const Vector3& v) const { return {x + v.x, y + v.y, z + v.z}; }
+	Vector3 operator-(const Vector3& v) const { return {x - v.x, y - v.y, z - v.z}; }
+	Vector3 operator*(Fix12i s) const { return {x * s, y * s, z * s}; }
+	Vector3 operator>>(int shift) const { return {x >> shift, y >> shift, z >> shift}; }
+
+	Vector3& operator+=(const Vector3& v) { return *this = *this + v; }
+	Vector3& operator-=(const Vector3& v) { return *this = *this - v; }
+
+	bool operator==(const Vector3&) const = default;
+
+	Fix12i Dist(const Vector3& v) const;
+};
+
+[[noreturn]] void Crash();
+
+/* -------- -------- Actors -------- -------- */
+
+struct ActorBase
+{
+	unsigned uniqueID = 0;
+	uint16_t actorID = 0;
+
+	virtual ~ActorBase() = default;
+	virtual int InitResources() { return 1; }
+	virtual int CleanupResources() { return 1; }
+	virtual bool BeforeBehavior() { return true; }
+	virtual bool BeforeRender() { return true; }
+};
+
+struct Actor : ActorBase
+{
+	unsigned param1 = 0;
+	Vector3 pos = {};
+	Vector3_16 ang = {};
+};
+
+struct Player : Actor {};
+
+extern Player* PLAYER_ARR[4];
+
+struct SpawnInfo
+{
+	ActorBase* (*spawnFunc)();
+	uint16_t behavPriority;
+	uint16_t renderPriority;
+	unsigned flags;
+	Fix12i rangeOffsetY;
+	Fix12i range;
+	Fix12i drawDist;
+	Fix12i unkc0;
+};
+
+extern SpawnInfo* ACTOR_SPAWN_TABLE[0x400];
+extern uint16_t OBJ_TO_ACTOR_ID_TABLE[0x400];
+
+/* -------- -------- Collision -------- -------- */
+
+struct CLPS
+{
+	unsigned low;
+	unsigned high;
+};
+
+struct LevelOverlay
+{
+	CLPS (*clps)[0x100];
+};
+
+extern LevelOverlay LEVEL_OVERLAY;
+
+struct SurfaceInfo
+{
+	CLPS clps;
+	Vector3 normal;
+};
+
+struct ClsnResult
+{
+	SurfaceInfo surfaceInfo;
+	short triangleID;
+};
+
+struct ClsnQuery
+{
+	unsigned passThroughMask = 0; // stands in for the flags the game filters surfaces by
+
+	bool ShouldPassThrough(const CLPS& clps, bool) const { return clps.low & passThroughMask; }
+};
+
+struct RaycastGround : ClsnQuery
+{
+	Vector3 pos = {};
+	Fix12i clsnPosY = {};
+	bool hadCollision = false;
+	ClsnResult result = {};
+};
+
+struct Line
+{
+	Vector3 pos0;
+	Vector3 pos1;
+};
+
+struct RaycastLine : ClsnQuery
+{
+	Line line = {};
+	Vector3 clsnPos = {};
+	bool hadCollision = false;
+	ClsnResult result = {};
+};
+
+struct SphereClsn : ClsnQuery
+{
+	enum Flags : unsigned
+	{
+		COLLISION_EXISTS = 1 << 0,
+		ON_GROUND        = 1 << 1,
+	};
+
+	Vector3 pos = {};
+	Fix12i radius = {};
+	Vector3 pushback0 = {};
+	Vector3 pushback1 = {};
+	unsigned resultFlags = 0;
+	ClsnResult result = {};
+	ClsnResult floorResult = {};
+	Vector3 storedNormal = {};
+};
+
+struct MeshColliderBase
+{
+	virtual ~MeshColliderBase() = default;
+
+	virtual void GetSurfaceInfo(short triangleID, SurfaceInfo& res) = 0;
+	virtual void GetNormal(short triangleID, Vector3& res) = 0;
+	virtual void GetTriangleOrigin(short triangleID, Vector3& res) = 0;
+	virtual bool DetectClsn(RaycastGround& ray) = 0;
+	virtual bool DetectClsn(RaycastLine& ray) = 0;
+	virtual unsigned DetectClsn(SphereClsn& sphere) = 0;
+
+	void Enable();
+	void Disable();
+};
+
+/* -------- -------- Files -------- -------- */
+
+struct SharedFilePtr
+{
+	unsigned ov0FileID = 0;
+
+	SharedFilePtr& Construct(unsigned ov0FileID) { this->ov0FileID = ov0FileID; return *this; }
+	char* Load();
+	void Release() {}
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "bench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+Player* PLAYER_ARR[4];
+SpawnInfo* ACTOR_SPAWN_TABLE[0x400];
+uint16_t OBJ_TO_ACTOR_ID_TABLE[0x400];
+LevelOverlay LEVEL_OVERLAY = {&Bench::clpsTable};
+
+namespace Bench
+{
+	std::vector<MeshColliderBase*> colliders;
+	std::map<unsigned, std::vector<char>> files;
+
+	CLPS clpsTable[0x100];
+
+	// Each CLPS has one of 8 bits set, which the pass through masks of the queries test
+	static const bool clpsTableFilled = []
+	{
+		for (unsigned i = 0; i < std::size(clpsTable); i++)
+			clpsTable[i] = {1u << (i & 7), i};
+
+		return true;
+	}();
+}
+
+[[noreturn]] void Crash()
+{
+	std::fputs("Crash() was called\n", stderr);
+	std::abort();
+}
+
+Fix12i Vector3::Dist(const Vector3& v) const
+{
+	const double dx = static_cast<double>(x - v.x);
+	const double dy = static_cast<double>(y - v.y);
+	const double dz = static_cast<double>(z - v.z);
+
+	return {static_cast<int>(std::sqrt(dx * dx + dy * dy + dz * dz) * 4096), as_raw};
+}
+
+void MeshColliderBase::Enable()
+{
+	if (std::ranges::find(Bench::colliders, this) == Bench::colliders.end())
+		Bench::colliders.push_back(this);
+}
+
+void MeshColliderBase::Disable()
+{
+	std::erase(Bench::colliders, this);
+}
+
+char* SharedFilePtr::Load()
+{
+	const auto file = Bench::files.find(ov0FileID);
+	if (file == Bench::files.end()) Crash();
+
+	return file->second.data();
+}
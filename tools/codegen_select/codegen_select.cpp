@@ -0,0 +1,368 @@
+// Chooses how to compile each file of newcode from a profile of a PROFILE=1 build
+// (see source/func_profiler.cpp) and writes the choice as a makefile for
+// make CODEGEN=codegen.mk. The profile is the "prof" lines of the emulator's log,
+// which give the address of each function that ran and the time spent in it.
+//
+// GCC takes -marm/-mthumb and -O2/-Os per file, so the time of the functions is
+// added up by the file they're in, from build_profile/newcode.map. A file can
+// only be Thumb if it has no hooks, which the game calls with BL from ARM code,
+// and no inline assembly, which is written for ARM. Functions with a
+// gnu::target attribute keep it either way.
+//
+// Every file that can be starts out as Thumb at -Os, and the rest as ARM at -Os.
+// Then the files with the most time per byte of growth become ARM at -O2, or
+// ARM at -Os if that doesn't fit, until the code would grow by more than the
+// budget compared to compiling everything as ARM at -Os. The sizes come from
+// build/newcode.map, which was built with --current (default: none), and the
+// sizes of the other modes are estimated from them.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+enum Mode { ARM_OS, THUMB_OS, ARM_O2, NUM_MODES };
+
+constexpr const char* modeNames[] = {"ARM -Os", "Thumb -Os", "ARM -O2"};
+constexpr const char* modeFlags[] = {"-marm -Os", "-mthumb -Os", "-marm -O2"};
+
+// Rough sizes of the code in each mode compared to ARM at -Os. They're only
+// estimates, so build and check with tools/mem_budget after changing the budget.
+constexpr double sizeRatios[] = {1.0, 0.70, 1.25};
+
+struct TextSection
+{
+	uint32_t addr;
+	uint32_t size;
+	std::string file;
+};
+
+struct File
+{
+	std::string name;
+	fs::path source;
+	const char* armOnlyReason = nullptr; // nullptr if it can be Thumb
+	uint64_t ticks = 0;
+	uint64_t calls = 0;
+	uint32_t size = 0;    // in build/newcode.map
+	Mode builtAs = ARM_OS;
+	double armOsSize = 0; // estimated
+	Mode mode = ARM_OS;
+};
+
+[[noreturn]] static void Fail(const char* message, const std::string& arg = "")
+{
+	std::fprintf(stderr, "error: %s%s\n", message, arg.c_str());
+	std::exit(1);
+}
+
+static std::vector<std::string> ReadLines(const fs::path& path)
+{
+	std::ifstream file(path);
+	if (!file) Fail("can't open ", path.string());
+
+	std::vector<std::string> res;
+	for (std::string line; std::getline(file, line);)
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		res.push_back(line);
+	}
+
+	return res;
+}
+
+// The code of each object file of newcode in a GNU ld map. Sections of
+// libraries like "libgcc.a(_udivsi3.o)" are skipped because they're prebuilt.
+static std::vector<TextSection> ParseMap(const fs::path& path)
+{
+	static const std::regex sectionLine(R"(^ (\.\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$)");
+	static const std::regex wrappedName(R"(^ (\.\S+)$)");
+	static const std::regex wrappedRest(R"(^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$)");
+
+	std::vector<TextSection> res;
+
+	bool inMemoryMap = false;
+	std::string pendingName;
+
+	for (const std::string& line : ReadLines(path))
+	{
+		if (line.starts_with("Linker script and memory map"))
+		{
+			inMemoryMap = true;
+			continue;
+		}
+
+		if (!inMemoryMap) continue;
+
+		std::smatch match;
+		std::string name, file;
+		uint32_t addr, size;
+
+		if (!pendingName.empty() && std::regex_match(line, match, wrappedRest))
+		{
+			name = pendingName;
+			addr = std::stoul(match[1], nullptr, 16);
+			size = std::stoul(match[2], nullptr, 16);
+			file = match[3];
+		}
+		else if (std::regex_match(line, match, sectionLine))
+		{
+			name = match[1];
+			addr = std::stoul(match[2], nullptr, 16);
+			size = std::stoul(match[3], nullptr, 16);
+			file = match[4];
+		}
+		else
+		{
+			pendingName = std::regex_match(line, match, wrappedName) ? match[1].str() : "";
+			continue;
+		}
+
+		pendingName.clear();
+
+		const bool isCode = name.starts_with(".text") || name.starts_with(".itcm");
+		if (!isCode || size == 0 || addr == 0 || !file.ends_with(".o") || file.find('(') != std::string::npos)
+			continue;
+
+		res.push_back({addr, size, fs::path(file).filename().string()});
+	}
+
+	std::ranges::sort(res, {}, &TextSection::addr);
+	return res;
+}
+
+// The modes in a makefile written by this tool
+static std::map<std::string, Mode> ParseCodegen(const fs::path& path)
+{
+	static const std::regex modeLine(R"(^(\S+\.o): CODEGENFLAGS := (.*)$)");
+
+	std::map<std::string, Mode> res;
+
+	for (const std::string& line : ReadLines(path))
+	{
+		std::smatch match;
+		if (!std::regex_match(line, match, modeLine)) continue;
+
+		const auto flags = std::ranges::find(modeFlags, match[2].str());
+		if (flags == std::end(modeFlags)) Fail("unknown flags in ", line);
+
+		res[match[1]] = static_cast<Mode>(flags - std::begin(modeFlags));
+	}
+
+	return res;
+}
+
+static fs::path FindSource(const fs::path& root, const std::string& object)
+{
+	const std::string stem = fs::path(object).stem().string();
+
+	for (const char* dir : {"source", "libc"})
+		for (const char* ext : {".cpp", ".c"})
+			if (fs::exists(root / dir / (stem + ext)))
+				return root / dir / (stem + ext);
+
+	return {}; // an assembly file
+}
+
+static const char* ArmOnlyReason(const fs::path& source)
+{
+	static const std::regex hook(R"(\b(nsub|repl|hook)_[0-9a-fA-F]{8}\b)");
+	static const std::regex inlineAsm(R"(\basm\b)");
+
+	std::ifstream file(source);
+	const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+	if (std::regex_search(text, hook)) return "hooks";
+	if (std::regex_search(text, inlineAsm)) return "asm";
+
+	return nullptr;
+}
+
+static double SizeIn(const File& file, Mode mode)
+{
+	return file.armOsSize * sizeRatios[mode];
+}
+
+static void Choose(std::vector<File*>& files, double budget)
+{
+	double growth = 0;
+
+	for (File* file : files)
+	{
+		file->mode = file->armOnlyReason ? ARM_OS : THUMB_OS;
+		growth += SizeIn(*file, file->mode) - file->armOsSize;
+	}
+
+	// First the hot files become ARM at -O2, then the ones that are still Thumb become ARM at -Os
+	for (Mode to : {ARM_O2, ARM_OS})
+	{
+		const auto CanBecome = [to](const File* file)
+		{
+			return file->ticks != 0 && (to == ARM_O2 ? file->mode != ARM_O2 : file->mode == THUMB_OS);
+		};
+
+		const auto TicksPerByte = [&](const File* file)
+		{
+			return CanBecome(file) ? file->ticks / (SizeIn(*file, to) - SizeIn(*file, file->mode)) : -1.0;
+		};
+
+		std::ranges::stable_sort(files, std::greater{}, TicksPerByte);
+
+		for (File* file : files)
+		{
+			if (!CanBecome(file)) continue;
+
+			const double extra = SizeIn(*file, to) - SizeIn(*file, file->mode);
+			if (growth + extra > budget) continue;
+
+			growth += extra;
+			file->mode = to;
+		}
+	}
+}
+
+static void Write(const fs::path& path, const std::vector<File*>& files, double budget, double growth)
+{
+	std::ofstream out(path);
+	if (!out) Fail("can't write ", path.string());
+
+	out << "# Written by tools/codegen_select, for make CODEGEN=" << path.filename().string() << "\n";
+	out << "# budget " << std::lround(budget) << " bytes, estimated growth " << std::lround(growth) << " bytes\n";
+
+	for (const File* file : files)
+		out << file->name << ": CODEGENFLAGS := " << modeFlags[file->mode] << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	fs::path root = "../..";
+	fs::path outPath;
+	fs::path currentPath;
+	double budget = 0;
+	std::vector<fs::path> profilePaths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const auto NextArg = [&] { if (++i == argc) Fail("missing value for ", argv[i - 1]); return argv[i]; };
+
+		if (std::strcmp(argv[i], "--root") == 0) root = NextArg();
+		else if (std::strcmp(argv[i], "--out") == 0) outPath = NextArg();
+		else if (std::strcmp(argv[i], "--current") == 0) currentPath = NextArg();
+		else if (std::strcmp(argv[i], "--budget") == 0) budget = std::stol(NextArg());
+		else if (argv[i][0] != '-') profilePaths.push_back(argv[i]);
+		else
+		{
+			profilePaths.clear();
+			break;
+		}
+	}
+
+	if (profilePaths.empty())
+	{
+		std::fputs(
+			"usage: codegen_select [--root DIR] [--budget BYTES] [--current FILE] [--out FILE] LOG...\n"
+			"  --root DIR      the repository with build/ and build_profile/ (default: ../..)\n"
+			"  --budget BYTES  how much the code may grow compared to ARM -Os everywhere (default: 0)\n"
+			"  --current FILE  the CODEGEN file build/ was built with (default: none)\n"
+			"  --out FILE      the makefile to write (default: ROOT/codegen.mk)\n"
+			"  LOG             the logs with the output of a PROFILE=1 build\n",
+			stderr
+		);
+		return 1;
+	}
+
+	if (outPath.empty()) outPath = root / "codegen.mk";
+
+	const std::vector<TextSection> profileSections = ParseMap(root / "build_profile/newcode.map");
+	const fs::path sizeMap = fs::exists(root / "build/newcode.map") ? root / "build/newcode.map" : root / "build_profile/newcode.map";
+	const std::map<std::string, Mode> current = currentPath.empty() ? std::map<std::string, Mode>{} : ParseCodegen(currentPath);
+
+	std::map<std::string, File> files;
+
+	for (const TextSection& section : ParseMap(sizeMap))
+		files[section.file].size += section.size;
+
+	if (!fs::exists(root / "build/newcode.map"))
+		std::fprintf(stderr, "warning: no build/newcode.map, the sizes include the profiling code\n");
+
+	// The profile
+	static const std::regex profLine(R"(prof (0x[0-9a-fA-F]+|\d+) (\d+) (\d+))");
+	uint64_t totalTicks = 0, unknownTicks = 0;
+
+	for (const fs::path& path : profilePaths)
+	{
+		for (const std::string& line : ReadLines(path))
+		{
+			std::smatch match;
+			if (!std::regex_search(line, match, profLine)) continue;
+
+			const uint32_t addr = std::stoul(match[1], nullptr, 0) & ~1u;
+			const uint64_t ticks = std::stoull(match[2]);
+			totalTicks += ticks;
+
+			const auto section = std::ranges::upper_bound(profileSections, addr, {}, &TextSection::addr);
+			if (section == profileSections.begin() || addr >= section[-1].addr + section[-1].size || !files.contains(section[-1].file))
+			{
+				unknownTicks += ticks;
+				continue;
+			}
+
+			File& file = files[section[-1].file];
+			file.ticks += ticks;
+			file.calls += std::stoull(match[3]);
+		}
+	}
+
+	if (totalTicks == 0) Fail("no profile in the logs, are they from a PROFILE=1 build?");
+
+	std::vector<File*> chosen;
+
+	for (auto& [name, file] : files)
+	{
+		file.name = name;
+		file.source = FindSource(root, name);
+		if (file.source.empty()) continue;
+
+		const auto mode = current.find(name);
+		file.builtAs = mode != current.end() ? mode->second : ARM_OS;
+		file.armOsSize = file.size / sizeRatios[file.builtAs];
+		file.armOnlyReason = ArmOnlyReason(file.source);
+
+		chosen.push_back(&file);
+	}
+
+	Choose(chosen, budget);
+
+	double growth = 0;
+	for (const File* file : chosen)
+		growth += SizeIn(*file, file->mode) - file->armOsSize;
+
+	std::ranges::sort(chosen, std::greater{}, &File::ticks);
+
+	std::printf("  %-28s %7s %10s %8s %8s  %-10s %s\n", "file", "time", "calls", "size", "new size", "mode", "");
+	for (const File* file : chosen)
+	{
+		std::printf("  %-28s %6.2f%% %10llu %8u %8.0f  %-10s %s\n", file->name.c_str(), 100.0 * file->ticks / totalTicks,
+			static_cast<unsigned long long>(file->calls), file->size, SizeIn(*file, file->mode), modeNames[file->mode],
+			file->armOnlyReason ? file->armOnlyReason : "");
+	}
+
+	std::printf("\n  time outside of these files: %.2f%%\n", 100.0 * unknownTicks / totalTicks);
+	std::printf("  estimated growth compared to ARM -Os: %+.0f bytes (budget %+.0f)\n", growth, budget);
+
+	std::ranges::sort(chosen, {}, &File::name);
+	Write(outPath, chosen, budget, growth);
+
+	std::printf("  written %s\n", outPath.string().c_str());
+}
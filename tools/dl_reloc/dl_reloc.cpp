@@ -0,0 +1,446 @@
+// Writes the images of a DL linked at 0x02400000 and 0x02400004 that SM64DSe's
+// insertDLs compares to find the words that change when the DL moves. Instead of
+// linking the DL twice, it's linked once with --emit-relocs, and the second image
+// is the first one with the relocations the linker kept applied to it.
+//
+// Every relocation the linker kept is sorted into one of three groups by what
+// its symbol is. Symbols from symbols9.x are absolute, so pointers to them stay
+// the same and PC-relative references to them change when the DL moves. Symbols
+// of the DL itself are the other way around. Everything else the tool can't
+// fix up is an error, so the DL is never silently broken where it's loaded.
+//
+// Veneers the linker adds for calls to the game use absolute literals, so they
+// need no relocation, but the branch to a veneer still carries the relocation of
+// the call. Those are recognized by the branch not going where the symbol is.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct ElfHeader
+{
+	uint8_t ident[16];
+	uint16_t type;
+	uint16_t machine;
+	uint32_t version;
+	uint32_t entry;
+	uint32_t phoff;
+	uint32_t shoff;
+	uint32_t flags;
+	uint16_t ehsize;
+	uint16_t phentsize;
+	uint16_t phnum;
+	uint16_t shentsize;
+	uint16_t shnum;
+	uint16_t shstrndx;
+};
+
+struct SectionHeader
+{
+	uint32_t name;
+	uint32_t type;
+	uint32_t flags;
+	uint32_t addr;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t link;
+	uint32_t info;
+	uint32_t addralign;
+	uint32_t entsize;
+};
+
+struct Symbol
+{
+	uint32_t name;
+	uint32_t value;
+	uint32_t size;
+	uint8_t info;
+	uint8_t other;
+	uint16_t shndx;
+};
+
+struct Rel
+{
+	uint32_t offset;
+	uint32_t info;
+};
+
+constexpr uint32_t SHT_SYMTAB   = 2;
+constexpr uint32_t SHT_RELA     = 4;
+constexpr uint32_t SHT_NOBITS   = 8;
+constexpr uint32_t SHT_REL      = 9;
+constexpr uint32_t SHF_ALLOC    = 2;
+constexpr uint16_t SHN_UNDEF    = 0;
+constexpr uint16_t SHN_ABS      = 0xfff1;
+constexpr uint16_t EM_ARM       = 40;
+
+enum ArmRelocType : uint8_t
+{
+	R_ARM_NONE        = 0,
+	R_ARM_PC24        = 1,
+	R_ARM_ABS32       = 2,
+	R_ARM_REL32       = 3,
+	R_ARM_LDR_PC_G0   = 4,
+	R_ARM_ABS16       = 5,
+	R_ARM_ABS12       = 6,
+	R_ARM_THM_ABS5    = 7,
+	R_ARM_ABS8        = 8,
+	R_ARM_THM_CALL    = 10,
+	R_ARM_THM_PC8     = 11,
+	R_ARM_PLT32       = 27,
+	R_ARM_CALL        = 28,
+	R_ARM_JUMP24      = 29,
+	R_ARM_THM_JUMP24  = 30,
+	R_ARM_TARGET1     = 38,
+	R_ARM_V4BX        = 40,
+	R_ARM_PREL31      = 42,
+	R_ARM_THM_JUMP11  = 102,
+	R_ARM_THM_JUMP8   = 103,
+};
+
+enum RelocType : uint8_t
+{
+	ABS32,        // a pointer into the DL
+	REL32,        // an offset from here to an address outside of the DL
+	ARM_BRANCH,   // B, BL or BLX to code outside of the DL
+	THUMB_BRANCH, // both halves of a Thumb BL or BLX to code outside of the DL
+};
+
+struct Reloc
+{
+	uint32_t offset;
+	RelocType type;
+};
+
+[[noreturn]] static void Fail(const char* message, const std::string& arg = "")
+{
+	std::fprintf(stderr, "error: %s%s\n", message, arg.c_str());
+	std::exit(1);
+}
+
+static std::string Hex(uint32_t value)
+{
+	char buffer[16];
+	std::snprintf(buffer, sizeof(buffer), "0x%08x", value);
+	return buffer;
+}
+
+class ElfFile
+{
+	std::string data;
+
+public:
+	ElfHeader header;
+	std::vector<SectionHeader> sections;
+
+	explicit ElfFile(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) Fail("can't open ", path);
+
+		data.assign(std::istreambuf_iterator<char>(file), {});
+
+		header = Read<ElfHeader>(0);
+		if (std::memcmp(header.ident, "\x7f" "ELF\x01\x01", 6) != 0 || header.machine != EM_ARM)
+			Fail("not a 32-bit little-endian ARM ELF file: ", path);
+
+		for (unsigned i = 0; i < header.shnum; i++)
+			sections.push_back(Read<SectionHeader>(header.shoff + i * header.shentsize));
+	}
+
+	template<class T>
+	T Read(size_t offset) const
+	{
+		if (offset + sizeof(T) > data.size()) Fail("truncated ELF file");
+
+		T res;
+		std::memcpy(&res, data.data() + offset, sizeof(T));
+		return res;
+	}
+
+	template<class T>
+	std::vector<T> ReadSection(const SectionHeader& section) const
+	{
+		std::vector<T> res(section.size / sizeof(T));
+		for (size_t i = 0; i < res.size(); i++)
+			res[i] = Read<T>(section.offset + i * sizeof(T));
+
+		return res;
+	}
+
+	std::string ReadString(unsigned sectionID, uint32_t offset) const
+	{
+		const size_t start = sections.at(sectionID).offset + offset;
+		if (start >= data.size()) Fail("truncated ELF file");
+
+		return data.c_str() + start;
+	}
+
+	std::string SectionName(const SectionHeader& section) const
+	{
+		return ReadString(header.shstrndx, section.name);
+	}
+};
+
+static uint32_t Read32(const std::vector<char>& code, uint32_t offset)
+{
+	uint32_t res;
+	std::memcpy(&res, code.data() + offset, 4);
+	return res;
+}
+
+static uint16_t Read16(const std::vector<char>& code, uint32_t offset)
+{
+	uint16_t res;
+	std::memcpy(&res, code.data() + offset, 2);
+	return res;
+}
+
+static void Write32(std::vector<char>& code, uint32_t offset, uint32_t value)
+{
+	std::memcpy(code.data() + offset, &value, 4);
+}
+
+static void Write16(std::vector<char>& code, uint32_t offset, uint16_t value)
+{
+	std::memcpy(code.data() + offset, &value, 2);
+}
+
+// Where the B, BL or BLX at the address goes
+static uint32_t ArmBranchTarget(uint32_t instr, uint32_t addr)
+{
+	const int32_t offset = static_cast<int32_t>(instr << 8) >> 6;
+	const bool isBLX = (instr >> 28) == 0xf;
+
+	return addr + 8 + offset + (isBLX ? (instr >> 23 & 2) : 0);
+}
+
+// Where the Thumb BL or BLX at the address goes
+static uint32_t ThumbBranchTarget(uint16_t first, uint16_t second, uint32_t addr)
+{
+	const int32_t offset = static_cast<int32_t>(((first & 0x7ff) << 11 | (second & 0x7ff)) << 10) >> 9;
+	const bool isBLX = (second & 0xf800) == 0xe800;
+
+	return (isBLX ? addr & ~3u : addr) + 4 + offset;
+}
+
+static void WriteFile(const char* path, const void* data, size_t size)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.write(static_cast<const char*>(data), size)) Fail("can't write ", path);
+}
+
+// Changes the code for being loaded delta bytes after its link address, which has to be a multiple of 4
+static void Relocate(std::vector<char>& code, const std::vector<Reloc>& relocs, uint32_t delta)
+{
+	for (const Reloc& reloc : relocs)
+	{
+		switch (reloc.type)
+		{
+		case ABS32:
+			Write32(code, reloc.offset, Read32(code, reloc.offset) + delta);
+			break;
+
+		case REL32:
+			Write32(code, reloc.offset, Read32(code, reloc.offset) - delta);
+			break;
+
+		case ARM_BRANCH:
+		{
+			const uint32_t instr = Read32(code, reloc.offset);
+			Write32(code, reloc.offset, (instr & 0xff000000) | ((instr - (delta >> 2)) & 0x00ffffff));
+			break;
+		}
+
+		case THUMB_BRANCH:
+		{
+			const uint16_t first = Read16(code, reloc.offset);
+			const uint16_t second = Read16(code, reloc.offset + 2);
+			const uint32_t offset = ((first & 0x7ff) << 11 | (second & 0x7ff)) - (delta >> 1);
+
+			Write16(code, reloc.offset, (first & 0xf800) | (offset >> 11 & 0x7ff));
+			Write16(code, reloc.offset + 2, (second & 0xf800) | (offset & 0x7ff));
+			break;
+		}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 4)
+	{
+		std::fputs(
+			"usage: dl_reloc newcode.elf newcode_lo.bin newcode_hi.bin\n"
+			"The ELF file has to be linked at 0x02400000 with --emit-relocs.\n",
+			stderr
+		);
+		return 1;
+	}
+
+	const char* const inPath = argv[1];
+	const char* const loPath = argv[2];
+	const char* const hiPath = argv[3];
+
+	const ElfFile elf(inPath);
+
+	// linker.x puts almost everything into .text, but sections it doesn't know,
+	// like the ones of libc, end up next to it. Like objcopy -O binary, the DL is
+	// everything from the first to the last allocated section.
+	std::vector<bool> isLoaded(elf.sections.size());
+	unsigned symtabID = 0;
+	uint32_t linkAddr = UINT32_MAX;
+	uint32_t binEnd = 0;
+	uint32_t loadEnd = 0;
+
+	for (unsigned i = 0; i < elf.sections.size(); i++)
+	{
+		const SectionHeader& section = elf.sections[i];
+
+		if (section.type == SHT_SYMTAB)
+			symtabID = i;
+		else if (section.type == SHT_RELA)
+			Fail("RELA sections are not supported: ", elf.SectionName(section));
+		else if (section.flags & SHF_ALLOC && section.size != 0)
+		{
+			if (elf.SectionName(section) == ".itcm")
+				Fail("DLs can't use ITCM_CODE, ITCM is only for the main code");
+
+			isLoaded[i] = true;
+			linkAddr = std::min(linkAddr, section.addr);
+			loadEnd = std::max(loadEnd, section.addr + section.size);
+
+			if (section.type != SHT_NOBITS)
+				binEnd = std::max(binEnd, section.addr + section.size);
+		}
+	}
+
+	if (binEnd == 0) Fail("the DL is empty");
+	if (symtabID == 0) Fail("the DL has no symbol table");
+
+	const uint32_t binSize = binEnd - linkAddr;
+	const uint32_t loadSize = (loadEnd - linkAddr + 3) & ~3u;
+
+	std::vector<char> code(loadSize);
+	for (unsigned i = 0; i < elf.sections.size(); i++)
+	{
+		const SectionHeader& section = elf.sections[i];
+
+		if (isLoaded[i] && section.type != SHT_NOBITS)
+			for (uint32_t j = 0; j < section.size; j++)
+				code[section.addr - linkAddr + j] = elf.Read<char>(section.offset + j);
+	}
+
+	const auto IsInDL = [&](uint32_t addr) { return addr >= linkAddr && addr < linkAddr + loadSize; };
+
+	const SectionHeader& symtab = elf.sections[symtabID];
+	const std::vector<Symbol> symbols = elf.ReadSection<Symbol>(symtab);
+
+	std::vector<Reloc> relocs;
+
+	for (const SectionHeader& section : elf.sections)
+	{
+		if (section.type != SHT_REL || section.info >= isLoaded.size() || !isLoaded[section.info]) continue;
+
+		for (const Rel& rel : elf.ReadSection<Rel>(section))
+		{
+			const uint8_t type = rel.info & 0xff;
+			if (type == R_ARM_NONE || type == R_ARM_V4BX) continue;
+
+			const Symbol& symbol = symbols.at(rel.info >> 8);
+			const uint32_t offset = rel.offset - linkAddr;
+			const std::string where = " at " + Hex(rel.offset);
+
+			if (!IsInDL(rel.offset)) Fail("relocation outside of the DL", where);
+			if (symbol.shndx == SHN_UNDEF) Fail("undefined symbol", where);
+
+			const bool isExternal = symbol.shndx == SHN_ABS;
+
+			const auto Add = [&](RelocType relocType, uint32_t align)
+			{
+				if (offset % align != 0) Fail("misaligned relocation", where);
+				relocs.push_back({offset, relocType});
+			};
+
+			switch (type)
+			{
+			case R_ARM_ABS32:
+			case R_ARM_TARGET1:
+				if (!isExternal) Add(ABS32, 4);
+				break;
+
+			case R_ARM_REL32:
+				if (isExternal) Add(REL32, 4);
+				break;
+
+			case R_ARM_PC24:
+			case R_ARM_PLT32:
+			case R_ARM_CALL:
+			case R_ARM_JUMP24:
+			{
+				const uint32_t target = ArmBranchTarget(Read32(code, offset), rel.offset);
+
+				// A branch to a veneer stays inside the DL
+				if (isExternal && target == (symbol.value & ~1u))
+					Add(ARM_BRANCH, 4);
+				else if (!IsInDL(target))
+					Fail("branch to an unexpected address", where);
+
+				break;
+			}
+
+			case R_ARM_THM_CALL:
+			case R_ARM_THM_JUMP24:
+			{
+				if (offset + 4 > loadSize) Fail("truncated Thumb branch", where);
+
+				const uint32_t target = ThumbBranchTarget(Read16(code, offset), Read16(code, offset + 2), rel.offset);
+
+				if (isExternal && target == (symbol.value & ~1u))
+					Add(THUMB_BRANCH, 2);
+				else if (!IsInDL(target))
+					Fail("branch to an unexpected address", where);
+
+				break;
+			}
+
+			case R_ARM_LDR_PC_G0:
+			case R_ARM_THM_PC8:
+			case R_ARM_PREL31:
+			case R_ARM_THM_JUMP11:
+			case R_ARM_THM_JUMP8:
+				if (isExternal) Fail("PC-relative reference to the game that can't be relocated", where);
+				break;
+
+			case R_ARM_ABS16:
+			case R_ARM_ABS12:
+			case R_ARM_THM_ABS5:
+			case R_ARM_ABS8:
+				if (!isExternal) Fail("small absolute reference to the DL that can't be relocated", where);
+				break;
+
+			default:
+				Fail("unsupported relocation type", " " + std::to_string(type) + where);
+			}
+		}
+	}
+
+	std::ranges::sort(relocs, {}, &Reloc::offset);
+
+	for (size_t i = 1; i < relocs.size(); i++)
+		if (relocs[i].offset == relocs[i - 1].offset)
+			Fail("two relocations at ", Hex(linkAddr + relocs[i].offset));
+
+	WriteFile(loPath, code.data(), binSize);
+
+	Relocate(code, relocs, 4);
+	WriteFile(hiPath, code.data(), binSize);
+
+	std::printf("%s: %u bytes of code, %zu relocations\n", inPath, binSize, relocs.size());
+}
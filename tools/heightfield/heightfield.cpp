@@ -0,0 +1,194 @@
+// Converts a grayscale PGM image to the file format of the heightfield DL
+// (see dynamic_lib/source/heightfield/heightfield.h).
+//
+// Each pixel of the height image is a corner of the grid, so an image of
+// (w + 1) x (h + 1) pixels makes w x h cells. The optional CLPS image has one
+// pixel per cell, whose value is the CLPS index of the cell.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct Image
+{
+	unsigned width = 0;
+	unsigned height = 0;
+	std::vector<unsigned> pixels;
+};
+
+[[noreturn]] static void Fail(const char* message, const char* arg = "")
+{
+	std::fprintf(stderr, "error: %s%s\n", message, arg);
+	std::exit(1);
+}
+
+static unsigned ReadHeaderValue(const std::string& data, size_t& pos)
+{
+	while (pos < data.size())
+	{
+		if (data[pos] == '#')
+			while (pos < data.size() && data[pos] != '\n') pos++;
+		else if (std::isspace(static_cast<unsigned char>(data[pos])))
+			pos++;
+		else
+			break;
+	}
+
+	size_t end = pos;
+	while (end < data.size() && std::isdigit(static_cast<unsigned char>(data[end]))) end++;
+
+	if (end == pos) Fail("malformed PGM header");
+
+	const unsigned res = std::stoul(data.substr(pos, end - pos));
+	pos = end;
+
+	return res;
+}
+
+// Reads a binary (P5) or plain (P2) PGM image with 8 or 16 bits per pixel
+static Image ReadPGM(const char* path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) Fail("can't open ", path);
+
+	const std::string data{std::istreambuf_iterator<char>(file), {}};
+
+	if (data.size() < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '2'))
+		Fail("not a PGM image: ", path);
+
+	size_t pos = 2;
+	Image res;
+	res.width = ReadHeaderValue(data, pos);
+	res.height = ReadHeaderValue(data, pos);
+	const unsigned maxVal = ReadHeaderValue(data, pos);
+
+	const size_t numPixels = static_cast<size_t>(res.width) * res.height;
+	res.pixels.resize(numPixels);
+
+	if (data[1] == '2')
+	{
+		for (unsigned& pixel : res.pixels)
+			pixel = ReadHeaderValue(data, pos);
+
+		return res;
+	}
+
+	pos++; // the single whitespace after the header
+
+	const size_t bytesPerPixel = maxVal > 0xff ? 2 : 1;
+
+	if (data.size() < pos + numPixels * bytesPerPixel)
+		Fail("truncated PGM image: ", path);
+
+	for (size_t i = 0; i < numPixels; i++)
+	{
+		const auto* p = reinterpret_cast<const uint8_t*>(&data[pos + i * bytesPerPixel]);
+		res.pixels[i] = bytesPerPixel == 2 ? p[0] << 8 | p[1] : p[0];
+	}
+
+	return res;
+}
+
+template<class T>
+static void Append(std::vector<char>& out, T val)
+{
+	for (size_t i = 0; i < sizeof(T); i++)
+		out.push_back(static_cast<char>(static_cast<uint64_t>(val) >> (8 * i)));
+}
+
+int main(int argc, char** argv)
+{
+	const char* heightsPath = nullptr;
+	const char* outPath = nullptr;
+	const char* clpsPath = nullptr;
+	double cellSize = 0;
+	double heightScale = 1;
+	unsigned defaultCLPS = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const auto NextArg = [&] { if (++i == argc) Fail("missing value for ", argv[i - 1]); return argv[i]; };
+
+		if      (!std::strcmp(argv[i], "--cell-size"))    cellSize = std::atof(NextArg());
+		else if (!std::strcmp(argv[i], "--height-scale")) heightScale = std::atof(NextArg());
+		else if (!std::strcmp(argv[i], "--clps"))         clpsPath = NextArg();
+		else if (!std::strcmp(argv[i], "--clps-index"))   defaultCLPS = std::atoi(NextArg());
+		else if (!heightsPath)                            heightsPath = argv[i];
+		else if (!outPath)                                outPath = argv[i];
+		else Fail("unknown argument ", argv[i]);
+	}
+
+	if (!heightsPath || !outPath || cellSize <= 0)
+	{
+		std::fprintf(stderr,
+			"usage: heightfield heights.pgm out.bin --cell-size N [--height-scale S]\n"
+			"                   [--clps clps.pgm | --clps-index N]\n"
+			"  --cell-size     size of a cell in world units\n"
+			"  --height-scale  world units per gray level (default: 1)\n"
+			"  --clps          image with the CLPS index of each cell\n"
+			"  --clps-index    CLPS index of all cells without a CLPS image (default: 0)\n");
+		return 1;
+	}
+
+	const Image heights = ReadPGM(heightsPath);
+
+	if (heights.width < 2 || heights.height < 2)
+		Fail("the height image needs at least 2x2 pixels");
+
+	const unsigned numCellsX = heights.width - 1;
+	const unsigned numCellsZ = heights.height - 1;
+
+	if (numCellsX * numCellsZ > 0x8000)
+		Fail("too many cells, the maximum is 0x8000");
+
+	std::vector<uint8_t> clpsIDs(numCellsX * numCellsZ, defaultCLPS);
+
+	if (clpsPath)
+	{
+		const Image clps = ReadPGM(clpsPath);
+
+		if (clps.width != numCellsX || clps.height != numCellsZ)
+			Fail("the CLPS image needs one pixel per cell");
+
+		for (size_t i = 0; i < clpsIDs.size(); i++)
+			clpsIDs[i] = clps.pixels[i];
+	}
+
+	// The smallest shift that makes every height fit in 16 bits
+	long long maxRaw = 0;
+
+	for (unsigned pixel : heights.pixels)
+		maxRaw = std::max(maxRaw, std::llround(pixel * heightScale * 4096));
+
+	unsigned heightShift = 0;
+	while ((maxRaw >> heightShift) > 0x7fff) heightShift++;
+
+	if (heightShift > 15)
+		Fail("the heights are too large for Fix12i");
+
+	std::vector<char> out;
+
+	Append<uint32_t>(out, 0x444c4648); // "HFLD"
+	Append<uint16_t>(out, numCellsX);
+	Append<uint16_t>(out, numCellsZ);
+	Append<int32_t>(out, std::lround(cellSize * 4096));
+	Append<uint8_t>(out, heightShift);
+	out.insert(out.end(), 3, 0);
+
+	for (unsigned pixel : heights.pixels)
+		Append<int16_t>(out, std::llround(pixel * heightScale * 4096) >> heightShift);
+
+	out.insert(out.end(), clpsIDs.begin(), clpsIDs.end());
+
+	std::ofstream(outPath, std::ios::binary).write(out.data(), out.size());
+
+	std::printf("%u x %u cells, height shift %u, %zu bytes\n", numCellsX, numCellsZ, heightShift, out.size());
+}
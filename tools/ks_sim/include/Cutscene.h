@@ -0,0 +1,156 @@
+#ifndef CUTSCENE_MOCK_INCLUDED
+#define CUTSCENE_MOCK_INCLUDED
+
+// A host-side stand-in for the Kuppa Script compiler of SM64DS-PI.
+// It produces the same instruction format that extended_ks.cpp expects:
+//
+// [0]    size of the instruction in bytes
+// [1]    instruction ID (0-3 = character, 0xff = current player, 4 = camera)
+// [2..3] first frame
+// [4..5] last frame (-1 = until the end of the script)
+// [6]    sub-ID
+// [7..]  parameters
+//
+// The script is terminated by a zero byte. The sub-IDs of the mocked
+// vanilla instructions don't match the ones in the game.
+
+#include "SM64DS_PI.h"
+#include <algorithm>
+
+namespace KuppaScriptImpl {
+
+template<uint8_t id>
+struct CharID_Type
+{
+	static constexpr uint8_t value = id;
+};
+
+template<class T>
+concept CharID = requires { { T::value } -> std::convertible_to<uint8_t>; };
+
+struct DefaultTag {};
+
+template<DefaultTag>
+struct DefaultScriptCompiler;
+
+template<template<std::size_t, class...> class Compiler>
+struct DefaultCharImpl;
+
+void RunScript(char* script);
+
+template<std::size_t size>
+consteval std::array<char, size> ToBytes(const auto& arg)
+{
+	return std::bit_cast<std::array<char, size>>(arg);
+}
+
+template<template<std::size_t, class...> class Derived, std::size_t scriptSize, class... Initializers>
+struct BaseScriptCompiler
+{
+	std::array<char, scriptSize> script;
+
+	template<std::size_t paramsSize, class... NewInitializers>
+	struct PendingInstruction
+	{
+		uint8_t id;
+		std::array<uint8_t, paramsSize> params;
+		std::array<char, scriptSize> script;
+
+		consteval auto operator()(short minFrame, short maxFrame) const
+		{
+			constexpr std::size_t instructionSize = paramsSize + 6;
+			static_assert(instructionSize < 0x100);
+
+			Derived<scriptSize + instructionSize, Initializers..., NewInitializers...> res = {};
+
+			std::ranges::copy(script, res.script.begin());
+
+			auto dest = res.script.begin() + scriptSize;
+
+			*dest++ = instructionSize;
+			*dest++ = id;
+			dest = std::ranges::copy(ToBytes<2>(minFrame), dest).out;
+			dest = std::ranges::copy(ToBytes<2>(maxFrame), dest).out;
+			std::ranges::copy(params, dest);
+
+			return res;
+		}
+
+		consteval auto operator()(short frame) const
+		{
+			return (*this)(frame, frame);
+		}
+	};
+
+	template<uint8_t id, uint8_t subID, class... NewInitializers>
+	consteval auto Instruction(const auto&... args) const
+	{
+		PendingInstruction<(sizeof(args) + ... + 1), NewInitializers...> res = {id, {subID}, script};
+
+		[[maybe_unused]] auto dest = res.params.begin() + 1;
+		((dest = std::ranges::copy(std::bit_cast<std::array<uint8_t, sizeof(args)>>(args), dest).out), ...);
+
+		return res;
+	}
+
+	template<uint8_t subID, class... NewInitializers>
+	consteval auto CamInstruction(const auto&... args) const
+	{
+		return Instruction<4, subID, NewInitializers...>(args...);
+	}
+
+	template<CharID Char, uint8_t subID, class... NewInitializers>
+	consteval auto PlayerInstruction(const auto&... args) const
+	{
+		return Instruction<Char::value, subID, NewInitializers...>(args...);
+	}
+
+	template<CharID Char = typename DefaultCharImpl<Derived>::Type>
+	consteval auto ActivatePlayer() const
+	{
+		return PlayerInstruction<Char, 0>();
+	}
+
+	template<CharID Char = typename DefaultCharImpl<Derived>::Type>
+	consteval auto PlayerHoldButtons(uint16_t buttons) const
+	{
+		return PlayerInstruction<Char, 1>(buttons);
+	}
+
+	consteval auto EnableAmbientSoundEffects() const
+	{
+		return CamInstruction<0>();
+	}
+
+	consteval auto End() const
+	{
+		Derived<scriptSize + 1, Initializers...> res = {};
+		std::ranges::copy(script, res.script.begin());
+
+		return res;
+	}
+
+	void Run()
+	{
+		(Initializers{}(script.data()), ...);
+
+		RunScript(script.data());
+	}
+};
+
+template<DefaultTag tag = {}>
+consteval auto NewScript()
+{
+	return typename DefaultScriptCompiler<tag>::Type{};
+}
+
+} // namespace KuppaScriptImpl
+
+using KuppaScriptImpl::NewScript;
+
+using Mario = KuppaScriptImpl::CharID_Type<0>;
+using Luigi = KuppaScriptImpl::CharID_Type<1>;
+using Wario = KuppaScriptImpl::CharID_Type<2>;
+using Yoshi = KuppaScriptImpl::CharID_Type<3>;
+
+#endif
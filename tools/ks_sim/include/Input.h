@@ -0,0 +1,27 @@
+#ifndef INPUT_MOCK_INCLUDED
+#define INPUT_MOCK_INCLUDED
+
+#include "SM64DS_PI.h"
+
+struct Input
+{
+	enum Buttons : uint16_t
+	{
+		A         = 1 << 0,
+		B         = 1 << 1,
+		SELECT    = 1 << 2,
+		START     = 1 << 3,
+		RIGHT     = 1 << 4,
+		LEFT      = 1 << 5,
+		UP        = 1 << 6,
+		DOWN      = 1 << 7,
+		R         = 1 << 8,
+		L         = 1 << 9,
+		X         = 1 << 10,
+		Y         = 1 << 11,
+		CAM_LEFT  = 1 << 12,
+		CAM_RIGHT = 1 << 13,
+	};
+};
+
+#endif
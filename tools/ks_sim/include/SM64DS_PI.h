@@ -0,0 +1,245 @@
+#ifndef SM64DS_PI_MOCK_INCLUDED
+#define SM64DS_PI_MOCK_INCLUDED
+
+// A host-side stand-in for the parts of SM64DS-PI used by the Kuppa Script
+// code. Only the members and functions that the custom instructions touch
+// are provided, and the game functions just record what they were asked to do.
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using u8  = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+
+template<class T, std::size_t n, std::size_t m>
+constexpr std::array<T, n + m> operator+(const std::array<T, n>& a, const std::array<T, m>& b)
+{
+	std::array<T, n + m> res;
+
+	for (std::size_t i = 0; i < n; i++) res[i] = a[i];
+	for (std::size_t i = 0; i < m; i++) res[n + i] = b[i];
+
+	return res;
+}
+
+/* -------- -------- Fixed point -------- -------- */
+
+struct AsRaw {};
+constexpr AsRaw as_raw;
+
+struct Fix12i
+{
+	int val;
+
+	constexpr Fix12i() = default;
+	constexpr Fix12i(int val, AsRaw): val(val) {}
+	constexpr Fix12i(int integer): val(integer << 12) {}
+
+	constexpr Fix12i operator-() const { return {-val, as_raw}; }
+
+	constexpr Fix12i operator+(Fix12i other) const { return {val + other.val, as_raw}; }
+	constexpr Fix12i operator-(Fix12i other) const { return {val - other.val, as_raw}; }
+
+	constexpr Fix12i operator*(Fix12i other) const
+	{
+		return {static_cast<int>((static_cast<int64_t>(val) * other.val + 0x800) >> 12), as_raw};
+	}
+
+	constexpr Fix12i operator/(Fix12i other) const
+	{
+		return {static_cast<int>((static_cast<int64_t>(val) << 12) / other.val), as_raw};
+	}
+
+	constexpr Fix12i operator>>(int shift) const { return {val >> shift, as_raw}; }
+	constexpr Fix12i operator<<(int shift) const { return {val << shift, as_raw}; }
+
+	constexpr Fix12i& operator+=(Fix12i other) { return *this = *this + other; }
+	constexpr Fix12i& operator-=(Fix12i other) { return *this = *this - other; }
+
+	constexpr auto operator<=>(const Fix12i&) const = default;
+
+	explicit constexpr operator double() const { return val / 4096.0; }
+};
+
+template<class T> concept FixedPoint = std::same_as<T, Fix12i>;
+
+template<class T> struct UnderlyingImpl { using Type = T; };
+template<> struct UnderlyingImpl<Fix12i> { using Type = int; };
+
+template<class T> using Underlying = UnderlyingImpl<T>::Type;
+
+consteval Fix12i operator""_f(unsigned long long val) { return {static_cast<int>(val), as_raw}; }
+consteval Fix12i operator""_f(long double val) { return {static_cast<int>(val * 4096), as_raw}; }
+
+consteval short operator""_deg(unsigned long long val) { return static_cast<short>(val * 0x10000 / 360); }
+consteval short operator""_deg(long double val) { return static_cast<short>(static_cast<long long>(val * 0x10000 / 360)); }
+
+inline Fix12i Abs(Fix12i x) { return x.val < 0 ? -x : x; }
+
+/* -------- -------- Vectors -------- -------- */
+
+struct Vector3_16
+{
+	short x, y, z;
+
+	constexpr bool operator==(const Vector3_16&) const = default;
+};
+
+struct Vector3_16f
+{
+	short x, y, z;
+};
+
+struct Vector3
+{
+	Fix12i x, y, z;
+
+	template<class F>
+	struct Proxy
+	{
+		F eval;
+
+		constexpr Proxy(F eval): eval(eval) {}
+
+		operator Vector3() const
+		{
+			Vector3 res;
+			eval.template operator()<false>(res);
+
+			return res;
+		}
+	};
+
+	static Vector3 Temp(Fix12i x, Fix12i y, Fix12i z) { return {x, y, z}; }
+
+	Vector3 operator+(const Vector3& v) const { return {x + v.x, y + v.y, z + v.z}; }
+	Vector3 operator-(const Vector3& v) const { return {x - v.x, y - v.y, z - v.z}; }
+	Vector3 operator*(Fix12i s) const { return {x * s, y * s, z * s}; }
+	Vector3 operator>>(int shift) const { return {x >> shift, y >> shift, z >> shift}; }
+
+	Vector3& operator+=(const Vector3& v) { return *this = *this + v; }
+	Vector3& operator-=(const Vector3& v) { return *this = *this - v; }
+
+	bool operator==(const Vector3&) const = default;
+
+	Fix12i Dist(const Vector3& v) const;
+};
+
+template<class T>
+inline T& AssureUnaliased(T& t) { return t; }
+
+Vector3 Lerp(const Vector3& a, const Vector3& b, Fix12i t);
+Fix12i SmoothStep(Fix12i t);
+
+short AngleDiff(short a, short b);
+bool ApproachAngle(short& angle, short targetAngle, int invFactor, int maxDelta, int minDelta);
+
+inline short ReadUnalignedShort(const char* ptr)
+{
+	return static_cast<short>(static_cast<uint8_t>(ptr[0]) | static_cast<uint8_t>(ptr[1]) << 8);
+}
+
+inline int ReadUnalignedInt(const char* ptr)
+{
+	return ReadUnalignedShort(ptr) & 0xffff | ReadUnalignedShort(ptr + 2) << 16;
+}
+
+/* -------- -------- Debug output -------- -------- */
+
+struct DebugOutput
+{
+	std::string buffer;
+
+	DebugOutput& operator<<(const char* str);
+	DebugOutput& operator<<(int val);
+	DebugOutput& operator<<(const Vector3& v);
+};
+
+extern DebugOutput cout;
+
+/* -------- -------- Actors -------- -------- */
+
+struct ActorBase
+{
+	unsigned uniqueID = 0;
+	uint16_t actorID = 0;
+
+	virtual ~ActorBase() = default;
+};
+
+struct Actor : ActorBase
+{
+	enum Flags : unsigned
+	{
+		UPDATE_DURING_STAR_SPAWNING = 1 << 26,
+		UPDATE_DURING_CUTSCENES     = 1 << 29,
+	};
+
+	unsigned flags = 0;
+	Vector3 pos = {};
+	Vector3 camSpacePos = {};
+	Vector3_16 ang = {};
+};
+
+class Player;
+class Camera;
+
+template<class Obj>
+using KS_MemberFuncPtr = void(Obj::*)(const char* params, short minFrame, short maxFrame);
+
+extern KS_MemberFuncPtr<Player> KS_PLAYER_FUNCTIONS[14];
+extern KS_MemberFuncPtr<Camera> KS_CAMERA_FUNCTIONS[39];
+
+class Player : public Actor
+{
+public:
+	unsigned playLongUniqueID = 0;
+	uint16_t buttonsHeld = 0;
+	Vector3 vel = {};
+
+	void CallKuppaScriptInstruction(char* instruction, short minFrame, short maxFrame);
+
+	void Hurt(const Vector3& source, unsigned damage, Fix12i speed, unsigned arg4, unsigned presetHurt, unsigned spawnOuchParticles);
+	void Burn();
+	void Shock(unsigned damage);
+	void Bounce(Fix12i initVel);
+
+	// Mocked vanilla instructions
+	void KS_Activate(const char* params, short minFrame, short maxFrame);
+	void KS_HoldButtons(const char* params, short minFrame, short maxFrame);
+};
+
+class Camera : public Actor
+{
+public:
+	Vector3 lookAt = {};
+	short angZ = 0;
+	short zShakeMaxAngle = 0;
+
+	void CallKuppaScriptInstruction(char* instruction, short minFrame, short maxFrame);
+
+	// Mocked vanilla instructions
+	void KS_EnableAmbientSoundEffects(const char* params, short minFrame, short maxFrame);
+};
+
+namespace Sound
+{
+	unsigned PlayLong(unsigned uniqueID, unsigned soundArchiveID, unsigned soundID, const Vector3& camSpacePos, unsigned arg4);
+}
+
+extern Player* PLAYER_ARR[4];
+extern Camera* CAMERA;
+extern short KS_FRAME_COUNTER;
+extern uint8_t AMBIENT_SOUND_EFFECTS_DISABLED;
+
+[[noreturn]] void Crash();
+
+#endif
@@ -0,0 +1,463 @@
+#include "sim.h"
+#include <algorithm>
+#include <climits>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string_view>
+
+// Runs a Kuppa Script compiled with ExtendedScriptCompiler frame by frame
+// against mock players and a mock camera. Records the state of each object on
+// every frame, how many times each instruction was dispatched and how long it
+// took, and which instructions write to the same state on the same frame.
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Instruction
+	{
+		char* ptr;
+		unsigned offset;
+		uint8_t id;
+		uint8_t subID;
+		short minFrame;
+		short maxFrame;
+
+		bool IsCamera() const { return id == 4; }
+		bool IsPlayer() const { return id < 4 || id == 0xff; }
+
+		bool IsActive(short frame) const
+		{
+			return frame >= minFrame && (maxFrame == -1 || frame <= maxFrame);
+		}
+
+		std::string Describe() const
+		{
+			std::string res = IsCamera() ? "camera" : id == 0xff ? "player" : "player " + std::to_string(id);
+			res += " sub-ID " + std::to_string(subID) + " at frame " + std::to_string(minFrame);
+
+			if (maxFrame != minFrame)
+				res += maxFrame == -1 ? " onwards" : " to " + std::to_string(maxFrame);
+
+			return res + " (offset " + std::to_string(offset) + ")";
+		}
+	};
+
+	std::vector<Instruction> ParseScript(char* script)
+	{
+		std::vector<Instruction> res;
+
+		for (char* ptr = script; *ptr; ptr += static_cast<uint8_t>(*ptr))
+		{
+			res.push_back({
+				.ptr      = ptr,
+				.offset   = static_cast<unsigned>(ptr - script),
+				.id       = static_cast<uint8_t>(ptr[1]),
+				.subID    = static_cast<uint8_t>(ptr[6]),
+				.minFrame = ReadUnalignedShort(ptr + 2),
+				.maxFrame = ReadUnalignedShort(ptr + 4),
+			});
+		}
+
+		return res;
+	}
+
+	/* -------- -------- State tracking -------- -------- */
+
+	struct Field
+	{
+		std::string name;
+		std::function<int(unsigned component)> get;
+		unsigned numComponents;
+	};
+
+	std::vector<Field> fields = []
+	{
+		std::vector<Field> res;
+
+		auto addVector = [&](std::string name, Vector3& v)
+		{
+			res.push_back({std::move(name), [&v](unsigned i) { return (&v.x)[i].val; }, 3});
+		};
+
+		for (unsigned i = 0; i < 4; i++)
+		{
+			Player& player = Sim::players[i];
+			const std::string prefix = "player" + std::to_string(i) + ".";
+
+			addVector(prefix + "pos", player.pos);
+			res.push_back({prefix + "ang.y", [&player](unsigned) { return player.ang.y; }, 1});
+			addVector(prefix + "vel", player.vel);
+			res.push_back({prefix + "flags", [&player](unsigned) { return static_cast<int>(player.flags); }, 1});
+			res.push_back({prefix + "buttonsHeld", [&player](unsigned) { return player.buttonsHeld; }, 1});
+		}
+
+		Camera& cam = Sim::camera;
+
+		addVector("camera.pos", cam.pos);
+		addVector("camera.lookAt", cam.lookAt);
+		res.push_back({"camera.angZ", [&cam](unsigned) { return cam.angZ; }, 1});
+		res.push_back({"camera.zShakeMaxAngle", [&cam](unsigned) { return cam.zShakeMaxAngle; }, 1});
+		res.push_back({"ambientSoundDisabled", [](unsigned) { return AMBIENT_SOUND_EFFECTS_DISABLED; }, 1});
+
+		return res;
+	}();
+
+	using Snapshot = std::vector<int>;
+
+	Snapshot TakeSnapshot()
+	{
+		Snapshot res;
+
+		for (const Field& field : fields)
+			for (unsigned i = 0; i < field.numComponents; i++)
+				res.push_back(field.get(i));
+
+		return res;
+	}
+
+	std::vector<std::size_t> GetChangedFields(const Snapshot& before, const Snapshot& after)
+	{
+		std::vector<std::size_t> res;
+
+		for (std::size_t fieldID = 0, valueID = 0; fieldID < fields.size(); fieldID++)
+		{
+			bool changed = false;
+
+			for (unsigned i = 0; i < fields[fieldID].numComponents; i++, valueID++)
+				changed |= before[valueID] != after[valueID];
+
+			if (changed) res.push_back(fieldID);
+		}
+
+		return res;
+	}
+
+	/* -------- -------- Statistics -------- -------- */
+
+	struct DispatchStats
+	{
+		unsigned long count = 0;
+		Clock::duration total = {};
+		Clock::duration max = {};
+	};
+
+	struct Conflict
+	{
+		short firstFrame;
+		unsigned numFrames;
+	};
+
+	struct Results
+	{
+		std::vector<Snapshot> trajectory;
+		std::map<std::pair<bool, uint8_t>, DispatchStats> dispatches; // key: (is camera, sub-ID)
+		std::map<std::tuple<unsigned, unsigned, std::size_t>, Conflict> conflicts; // key: (offset, offset, field)
+		Clock::duration totalTime = {};
+		unsigned numHeldFrames = 0; // frames on which WaitUntil held the script
+		bool stillHeld = false;
+	};
+
+	// A WaitUntil whose predicate never returns true would hold the script forever
+	constexpr unsigned maxHeldFrames = 10000;
+
+	void Dispatch(const Instruction& inst)
+	{
+		if (inst.IsCamera())
+			repl_0200ed4c(*CAMERA, inst.ptr, inst.minFrame, inst.maxFrame);
+		else if (inst.id == 0xff)
+			repl_0200e5f0(*PLAYER_ARR[0], inst.ptr, inst.minFrame, inst.maxFrame);
+		else
+			repl_0200e5f0(Sim::players[inst.id], inst.ptr, inst.minFrame, inst.maxFrame);
+	}
+
+	void RunFrame(const std::vector<Instruction>& instructions, Results& results, bool trackState)
+	{
+		std::map<std::size_t, unsigned> writers; // field -> offset of the instruction that changed it
+
+		for (const Instruction& inst : instructions)
+		{
+			if (!inst.IsActive(KS_FRAME_COUNTER) || !(inst.IsCamera() || inst.IsPlayer()))
+				continue;
+
+			Snapshot before;
+			if (trackState) before = TakeSnapshot();
+
+			const auto start = Clock::now();
+			Dispatch(inst);
+			const auto time = Clock::now() - start;
+
+			DispatchStats& stats = results.dispatches[{inst.IsCamera(), inst.subID}];
+			stats.count++;
+			stats.total += time;
+			stats.max = std::max(stats.max, time);
+			results.totalTime += time;
+
+			if (!trackState) continue;
+
+			for (std::size_t fieldID : GetChangedFields(before, TakeSnapshot()))
+			{
+				const auto [it, inserted] = writers.try_emplace(fieldID, inst.offset);
+				if (inserted) continue;
+
+				const auto [conflict, isNew] = results.conflicts.try_emplace({it->second, inst.offset, fieldID}, KS_FRAME_COUNTER, 0);
+				conflict->second.numFrames++;
+			}
+		}
+	}
+
+	Results Simulate(const std::vector<Instruction>& instructions, unsigned numFrames, unsigned numIterations, unsigned currentChar)
+	{
+		Results results;
+
+		for (unsigned iteration = 0; iteration < numIterations; iteration++)
+		{
+			const bool firstIteration = iteration == 0;
+
+			Sim::Reset(currentChar);
+
+			// Like in the game, the frame counter is only advanced after running the frame,
+			// so instructions like WaitUntil can hold the script on the same frame. The
+			// frames the script is held on don't count towards numFrames.
+			unsigned frame = 0;
+
+			for (; static_cast<unsigned>(KS_FRAME_COUNTER) < numFrames && frame < numFrames + maxHeldFrames; frame++)
+			{
+				RunFrame(instructions, results, firstIteration);
+				KS_FRAME_COUNTER++;
+
+				if (firstIteration)
+					results.trajectory.push_back(TakeSnapshot());
+			}
+
+			OnKuppaScriptEnd(); // like the game does when the script ends
+
+			if (firstIteration)
+			{
+				results.numHeldFrames = frame - KS_FRAME_COUNTER;
+				results.stillHeld = static_cast<unsigned>(KS_FRAME_COUNTER) < numFrames;
+			}
+		}
+
+		return results;
+	}
+
+	/* -------- -------- Reports -------- -------- */
+
+	unsigned GetScriptLength(const std::vector<Instruction>& instructions)
+	{
+		short lastFrame = 0;
+
+		for (const Instruction& inst : instructions)
+			lastFrame = std::max({lastFrame, inst.minFrame, inst.maxFrame});
+
+		return lastFrame + 1;
+	}
+
+	void PrintOverlaps(const std::vector<Instruction>& instructions)
+	{
+		std::puts("Overlapping windows of the same instruction:");
+		bool found = false;
+
+		for (auto a = instructions.begin(); a != instructions.end(); ++a)
+		{
+			for (auto b = a + 1; b != instructions.end(); ++b)
+			{
+				if (a->id != b->id || a->subID != b->subID) continue;
+
+				const short aEnd = a->maxFrame == -1 ? SHRT_MAX : a->maxFrame;
+				const short bEnd = b->maxFrame == -1 ? SHRT_MAX : b->maxFrame;
+
+				if (a->minFrame <= bEnd && b->minFrame <= aEnd)
+				{
+					std::printf("  %s\n  %s\n\n", a->Describe().c_str(), b->Describe().c_str());
+					found = true;
+				}
+			}
+		}
+
+		if (!found) std::puts("  none\n");
+	}
+
+	void PrintConflicts(const std::vector<Instruction>& instructions, const Results& results)
+	{
+		auto find = [&](unsigned offset)
+		{
+			return std::ranges::find(instructions, offset, &Instruction::offset);
+		};
+
+		std::puts("Instructions that changed the same state on the same frame:");
+
+		for (const auto& [key, conflict] : results.conflicts)
+		{
+			const auto& [offsetA, offsetB, fieldID] = key;
+
+			std::printf("  %s, first on frame %d, %u frame(s) in total\n    %s\n    %s\n\n",
+				fields[fieldID].name.c_str(), conflict.firstFrame, conflict.numFrames,
+				find(offsetA)->Describe().c_str(), find(offsetB)->Describe().c_str());
+		}
+
+		if (results.conflicts.empty()) std::puts("  none\n");
+	}
+
+	void PrintDispatches(const Results& results, unsigned numIterations)
+	{
+		using Entry = std::pair<std::pair<bool, uint8_t>, DispatchStats>;
+
+		std::vector<Entry> entries(results.dispatches.begin(), results.dispatches.end());
+
+		std::ranges::sort(entries, std::greater{}, [](const Entry& e) { return e.second.total; });
+
+		std::puts("Dispatches (sorted by total time):");
+		std::puts("  object   sub-ID      calls    total [us]   avg [ns]   max [ns]");
+
+		for (const auto& [key, stats] : entries)
+		{
+			using namespace std::chrono;
+
+			std::printf("  %-6s   %6u   %8lu   %11.1f   %8.1f   %8lld\n",
+				key.first ? "camera" : "player", key.second, stats.count / numIterations,
+				duration<double, std::micro>(stats.total).count() / numIterations,
+				duration<double, std::nano>(stats.total).count() / stats.count,
+				static_cast<long long>(duration_cast<nanoseconds>(stats.max).count()));
+		}
+
+		std::printf("\nTotal dispatch time per run: %.1f us\n\n",
+			std::chrono::duration<double, std::micro>(results.totalTime).count() / numIterations);
+	}
+
+	void WriteTrajectory(std::ostream& out, const std::vector<Snapshot>& trajectory)
+	{
+		out << "frame";
+
+		for (const Field& field : fields)
+		{
+			if (field.numComponents == 1)
+				out << ',' << field.name;
+			else
+				for (char c : std::string_view("xyz", field.numComponents))
+					out << ',' << field.name << '.' << c;
+		}
+
+		for (unsigned frame = 0; const Snapshot& snapshot : trajectory)
+		{
+			out << '\n' << frame++;
+
+			for (int value : snapshot)
+				out << ',' << value;
+		}
+
+		out << '\n';
+	}
+
+	// Returns the first line that differs, or nothing if the files are identical
+	std::optional<unsigned> CompareTrajectories(const std::string& path, const std::string& expected)
+	{
+		std::ifstream file(path);
+		if (!file) return 0;
+
+		std::string line, expectedLine;
+		std::istringstream expectedStream(expected);
+
+		for (unsigned lineID = 1;; lineID++)
+		{
+			const bool a = !!std::getline(file, line);
+			const bool b = !!std::getline(expectedStream, expectedLine);
+
+			if (!a && !b) return std::nullopt;
+			if (a != b || line != expectedLine) return lineID;
+		}
+	}
+
+	[[noreturn]] void Usage(const char* name)
+	{
+		std::fprintf(stderr,
+			"Usage: %s [options]\n"
+			"  --frames N        number of frames to simulate (default: until the last instruction)\n"
+			"  --iterations N    run the script N times and average the timings (default: 1)\n"
+			"  --player N        character controlled by the player, 0-3 (default: 0)\n"
+			"  --trajectory FILE write the state of every frame to a CSV file\n"
+			"  --compare FILE    compare the trajectory to a CSV file written earlier\n",
+			name);
+
+		std::exit(2);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::optional<unsigned> numFrames;
+	unsigned numIterations = 1;
+	unsigned currentChar = 0;
+	const char* trajectoryPath = nullptr;
+	const char* comparePath = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (i + 1 == argc) Usage(argv[0]);
+
+		if      (arg == "--frames")     numFrames      = std::atoi(argv[++i]);
+		else if (arg == "--iterations") numIterations  = std::max(std::atoi(argv[++i]), 1);
+		else if (arg == "--player")     currentChar    = std::atoi(argv[++i]) & 3;
+		else if (arg == "--trajectory") trajectoryPath = argv[++i];
+		else if (arg == "--compare")    comparePath    = argv[++i];
+		else Usage(argv[0]);
+	}
+
+	Sim::Reset(currentChar);
+	init();
+
+	if (!Sim::script)
+	{
+		std::fputs("The DL didn't run a script\n", stderr);
+		return 1;
+	}
+
+	const std::vector<Instruction> instructions = ParseScript(Sim::script);
+	if (!numFrames) numFrames = GetScriptLength(instructions);
+
+	const Results results = Simulate(instructions, *numFrames, numIterations, currentChar);
+
+	std::printf("%zu instructions, %u frames, held by WaitUntil on %u more\n\n", instructions.size(), *numFrames, results.numHeldFrames);
+
+	if (results.stillHeld)
+		std::printf("The script was still held by WaitUntil at frame %d\n\n", KS_FRAME_COUNTER);
+
+	PrintDispatches(results, numIterations);
+	PrintOverlaps(instructions);
+	PrintConflicts(instructions, results);
+
+	std::puts("Events:");
+	for (const auto& [frame, description] : Sim::events)
+		std::printf("  %4d: %s\n", frame, description.c_str());
+
+	std::printf("\nDebug output:\n%s\n", cout.buffer.c_str());
+
+	cleanup();
+
+	std::ostringstream trajectory;
+	WriteTrajectory(trajectory, results.trajectory);
+
+	if (trajectoryPath)
+		std::ofstream(trajectoryPath) << trajectory.str();
+
+	if (comparePath)
+	{
+		if (const auto line = CompareTrajectories(comparePath, trajectory.str()))
+		{
+			std::fprintf(stderr, "Trajectory differs from %s at line %u\n", comparePath, *line);
+			return 1;
+		}
+
+		std::printf("Trajectory matches %s\n", comparePath);
+	}
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+#include "sim.h"
+#include "Cutscene.h"
+#include "spawn_queue.h"
+#include <cstdio>
+#include <cstdlib>
+
+Player* PLAYER_ARR[4];
+Camera* CAMERA;
+short KS_FRAME_COUNTER;
+uint8_t AMBIENT_SOUND_EFFECTS_DISABLED;
+DebugOutput cout;
+
+namespace Sim
+{
+	constinit Player players[4];
+	constinit Camera camera;
+	std::vector<Event> events;
+	char* script = nullptr;
+
+	void LogEvent(std::string description)
+	{
+		events.emplace_back(KS_FRAME_COUNTER, std::move(description));
+	}
+
+	void Reset(unsigned currentChar)
+	{
+		for (Player& player : players)
+			player = {};
+
+		camera = {};
+		events.clear();
+		cout.buffer.clear();
+
+		PLAYER_ARR[0] = &players[currentChar];
+		CAMERA = &camera;
+		KS_FRAME_COUNTER = 0;
+		AMBIENT_SOUND_EFFECTS_DISABLED = 0;
+	}
+}
+
+void KuppaScriptImpl::RunScript(char* script)
+{
+	Sim::script = script;
+}
+
+[[noreturn]] void Crash()
+{
+	std::fputs("Crash() was called\n", stderr);
+	std::abort();
+}
+
+std::string Sim::ToString(Fix12i x)
+{
+	return std::to_string(static_cast<double>(x));
+}
+
+/* -------- -------- Math -------- -------- */
+
+Fix12i Vector3::Dist(const Vector3& v) const
+{
+	const double dx = static_cast<double>(x - v.x);
+	const double dy = static_cast<double>(y - v.y);
+	const double dz = static_cast<double>(z - v.z);
+
+	return {static_cast<int>(__builtin_sqrt(dx * dx + dy * dy + dz * dz) * 4096), as_raw};
+}
+
+Vector3 Lerp(const Vector3& a, const Vector3& b, Fix12i t)
+{
+	return a + (b - a) * t;
+}
+
+Fix12i SmoothStep(Fix12i t)
+{
+	if (t <= 0_f)  return 0_f;
+	if (t >= 1._f) return 1._f;
+
+	return t * t * (3._f - (t << 1));
+}
+
+short AngleDiff(short a, short b)
+{
+	const short diff = a - b;
+
+	return diff < 0 ? -diff : diff;
+}
+
+bool ApproachAngle(short& angle, short targetAngle, int invFactor, int maxDelta, int minDelta)
+{
+	const short diff = targetAngle - angle;
+	if (diff == 0) return true;
+
+	int delta = diff / invFactor;
+	const int absDelta = delta < 0 ? -delta : delta;
+
+	if (absDelta > maxDelta) delta = diff < 0 ? -maxDelta : maxDelta;
+	if (absDelta < minDelta) delta = diff < 0 ? -minDelta : minDelta;
+
+	const int absDiff = diff < 0 ? -diff : diff;
+
+	if ((delta < 0 ? -delta : delta) >= absDiff)
+	{
+		angle = targetAngle;
+		return true;
+	}
+
+	angle += delta;
+	return false;
+}
+
+/* -------- -------- Debug output -------- -------- */
+
+DebugOutput& DebugOutput::operator<<(const char* str)
+{
+	buffer += str;
+	return *this;
+}
+
+DebugOutput& DebugOutput::operator<<(int val)
+{
+	buffer += std::to_string(val);
+	return *this;
+}
+
+DebugOutput& DebugOutput::operator<<(const Vector3& v)
+{
+	buffer += "(" + Sim::ToString(v.x) + ", " + Sim::ToString(v.y) + ", " + Sim::ToString(v.z) + ")";
+	return *this;
+}
+
+/* -------- -------- Players -------- -------- */
+
+static unsigned GetCharID(const Player& player)
+{
+	return &player - Sim::players;
+}
+
+void Player::Hurt(const Vector3& source, unsigned damage, Fix12i speed, unsigned arg4, unsigned presetHurt, unsigned spawnOuchParticles)
+{
+	Sim::LogEvent("player " + std::to_string(GetCharID(*this)) + " hurt: damage " + std::to_string(damage) + ", speed " + Sim::ToString(speed));
+}
+
+void Player::Burn()
+{
+	Sim::LogEvent("player " + std::to_string(GetCharID(*this)) + " burned");
+}
+
+void Player::Shock(unsigned damage)
+{
+	Sim::LogEvent("player " + std::to_string(GetCharID(*this)) + " shocked: damage " + std::to_string(damage));
+}
+
+void Player::Bounce(Fix12i initVel)
+{
+	vel.y = initVel;
+	Sim::LogEvent("player " + std::to_string(GetCharID(*this)) + " bounced: velocity " + Sim::ToString(initVel));
+}
+
+unsigned Sound::PlayLong(unsigned uniqueID, unsigned soundArchiveID, unsigned soundID, const Vector3& camSpacePos, unsigned arg4)
+{
+	if (uniqueID == 0)
+		Sim::LogEvent("sound " + std::to_string(soundArchiveID) + ":" + std::to_string(soundID) + " started");
+
+	return uniqueID ? uniqueID : soundArchiveID << 16 | soundID;
+}
+
+void Player::CallKuppaScriptInstruction(char* instruction, short minFrame, short maxFrame)
+{
+	if (auto func = KS_PLAYER_FUNCTIONS[static_cast<uint8_t>(instruction[6])])
+		(this->*func)(instruction + 7, minFrame, maxFrame);
+}
+
+void Player::KS_Activate(const char* params, short minFrame, short maxFrame)
+{
+	flags |= UPDATE_DURING_STAR_SPAWNING | UPDATE_DURING_CUTSCENES;
+}
+
+void Player::KS_HoldButtons(const char* params, short minFrame, short maxFrame)
+{
+	buttonsHeld = ReadUnalignedShort(params);
+}
+
+/* -------- -------- Spawn queue -------- -------- */
+
+// Spawns aren't simulated, only logged
+void SpawnQueue::Push(
+	unsigned actorID, unsigned param1, const Vector3& pos, const Vector3_16* ang, int areaID, int deathTableID,
+	Priority priority, Callback callback, void* userData
+)
+{
+	Sim::LogEvent("actor " + std::to_string(actorID) + " queued with priority " + std::to_string(priority) + " at " +
+		Sim::ToString(pos.x) + ", " + Sim::ToString(pos.y) + ", " + Sim::ToString(pos.z));
+}
+
+/* -------- -------- Camera -------- -------- */
+
+void Camera::CallKuppaScriptInstruction(char* instruction, short minFrame, short maxFrame)
+{
+	if (auto func = KS_CAMERA_FUNCTIONS[static_cast<uint8_t>(instruction[6])])
+		(this->*func)(instruction + 7, minFrame, maxFrame);
+}
+
+void Camera::KS_EnableAmbientSoundEffects(const char* params, short minFrame, short maxFrame)
+{
+	AMBIENT_SOUND_EFFECTS_DISABLED = 0;
+}
+
+// The remaining vanilla instructions aren't simulated
+KS_MemberFuncPtr<Player> KS_PLAYER_FUNCTIONS[14] =
+{
+	&Player::KS_Activate,
+	&Player::KS_HoldButtons,
+};
+
+KS_MemberFuncPtr<Camera> KS_CAMERA_FUNCTIONS[39] =
+{
+	&Camera::KS_EnableAmbientSoundEffects,
+};
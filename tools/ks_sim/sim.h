@@ -0,0 +1,35 @@
+#ifndef KS_SIM_INCLUDED
+#define KS_SIM_INCLUDED
+
+#include "SM64DS_PI.h"
+#include <string>
+#include <vector>
+
+namespace Sim
+{
+	struct Event
+	{
+		short frame;
+		std::string description;
+	};
+
+	extern Player players[4];
+	extern Camera camera;
+	extern std::vector<Event> events;
+	extern char* script;
+
+	void LogEvent(std::string description);
+	std::string ToString(Fix12i x);
+	void Reset(unsigned currentChar);
+}
+
+// Defined in extended_ks.cpp
+int repl_0200e5f0(Player& player, char* instruction, short minFrame, short maxFrame);
+void repl_0200ed4c(Camera& cam, char* instruction, short minFrame, short maxFrame);
+void OnKuppaScriptEnd();
+
+// Defined in the DL that contains the script
+void init();
+void cleanup();
+
+#endif
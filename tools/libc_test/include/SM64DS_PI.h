@@ -0,0 +1,11 @@
+#ifndef SM64DS_PI_MOCK_INCLUDED
+#define SM64DS_PI_MOCK_INCLUDED
+
+// The replacement libc only needs the standard integer types from SM64DS-PI.
+// The C library headers of the host aren't included here, because their
+// declarations of memcpy and friends would conflict with the replacements.
+
+#include <cstddef>
+#include <cstdint>
+
+#endif
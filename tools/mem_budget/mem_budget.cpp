@@ -0,0 +1,531 @@
+// Reports how much memory the inserted code and the DLs take, by source file and
+// by function, from the link maps and the symbol tables of a build:
+//
+//   build/newcode.map, newcode.sym                                  main code
+//   dynamic_lib/build/<DL>/newcode.map, newcode_lo.sym              each DL
+//
+// The map tells which input section of which file each byte came from, which
+// sorts it into .text, .rodata, .data or .bss even though linker.x puts all of
+// them into one output section. The symbol tables add the size of each function
+// and variable. The regions of source/multiheap.cpp show what's left for heaps.
+//
+// --save writes everything to a file that --diff compares a later build to.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+enum Class { TEXT, RODATA, DATA, BSS, NUM_CLASSES };
+
+constexpr uint32_t itcmStart = 0x01ff8000;
+constexpr uint32_t itcmEnd   = 0x02000000;
+
+constexpr const char* classNames[] = {"text", "rodata", "data", "bss"};
+
+using Sizes = std::array<uint32_t, NUM_CLASSES>;
+
+struct InputSection
+{
+	uint32_t addr;
+	uint32_t size;
+	Class cls;
+	std::string file;
+	bool isInITCM;
+};
+
+struct Symbol
+{
+	std::string name;
+	std::string file;
+	Class cls;
+	uint32_t size;
+};
+
+struct Image
+{
+	std::string name;
+	uint32_t start = UINT32_MAX;
+	uint32_t end = 0;
+	uint32_t itcmSize = 0; // also part of total, and stored after the end until ITCM::Init copies it
+	Sizes total = {};
+	std::map<std::string, Sizes> files;
+	std::vector<Symbol> symbols;
+};
+
+[[noreturn]] static void Fail(const char* message, const std::string& arg = "")
+{
+	std::fprintf(stderr, "error: %s%s\n", message, arg.c_str());
+	std::exit(1);
+}
+
+static std::vector<std::string> ReadLines(const fs::path& path)
+{
+	std::ifstream file(path);
+	if (!file) Fail("can't open ", path.string());
+
+	std::vector<std::string> res;
+	for (std::string line; std::getline(file, line);)
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		res.push_back(line);
+	}
+
+	return res;
+}
+
+static Class ClassOf(const std::string& section)
+{
+	if (section.starts_with(".rodata")) return RODATA;
+	if (section.starts_with(".data")) return DATA;
+	if (section.starts_with(".bss") || section == "COMMON") return BSS;
+
+	return TEXT; // .text, and the sections of libc like .memcpy
+}
+
+static std::string Demangle(const std::string& name)
+{
+	int status;
+	std::unique_ptr<char, decltype(&std::free)> res(abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status), &std::free);
+
+	return status == 0 ? res.get() : name;
+}
+
+// "/long/path/libgcc.a(_udivsi3.o)" -> "libgcc.a(_udivsi3.o)"
+static std::string ShortFileName(const std::string& path)
+{
+	const size_t paren = path.find('(');
+	const size_t slash = path.rfind('/', paren);
+
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// The input sections of a GNU ld map, skipping the ones that aren't loaded
+static std::vector<InputSection> ParseMap(const fs::path& path)
+{
+	static const std::regex sectionLine(R"(^ (\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$)");
+	static const std::regex wrappedName(R"(^ (\S+)$)");
+	static const std::regex wrappedRest(R"(^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$)");
+
+	const std::vector<std::string> lines = ReadLines(path);
+	std::vector<InputSection> res;
+
+	bool inMemoryMap = false;
+	std::string pendingName;
+
+	for (const std::string& line : lines)
+	{
+		if (line.starts_with("Linker script and memory map"))
+		{
+			inMemoryMap = true;
+			continue;
+		}
+
+		if (!inMemoryMap) continue;
+
+		std::smatch match;
+		std::string name, file;
+		uint32_t addr, size;
+
+		if (!pendingName.empty() && std::regex_match(line, match, wrappedRest))
+		{
+			name = pendingName;
+			addr = std::stoul(match[1], nullptr, 16);
+			size = std::stoul(match[2], nullptr, 16);
+			file = match[3];
+		}
+		else if (std::regex_match(line, match, sectionLine))
+		{
+			name = match[1];
+			addr = std::stoul(match[2], nullptr, 16);
+			size = std::stoul(match[3], nullptr, 16);
+			file = match[4];
+		}
+		else
+		{
+			pendingName = std::regex_match(line, match, wrappedName) && line[1] == '.' ? match[1].str() : "";
+			continue;
+		}
+
+		pendingName.clear();
+
+		// Non-allocated sections like .comment and .debug_* are at address 0
+		if (size == 0 || addr == 0 || name == "*fill*" || name.starts_with(".debug") ||
+			name.starts_with(".ARM.") || name == ".comment")
+		{
+			continue;
+		}
+
+		res.push_back({addr, size, ClassOf(name), ShortFileName(file), addr >= itcmStart && addr < itcmEnd});
+	}
+
+	std::ranges::sort(res, {}, &InputSection::addr);
+	return res;
+}
+
+// The functions and variables in the output of objdump -t
+static std::vector<std::pair<uint32_t, Symbol>> ParseSymbols(const fs::path& path)
+{
+	static const std::regex symbolLine(R"(^([0-9a-f]{8}) (.{7}) (\S+)\t([0-9a-f]{8}) (.*)$)");
+
+	std::vector<std::pair<uint32_t, Symbol>> res;
+
+	for (const std::string& line : ReadLines(path))
+	{
+		std::smatch match;
+		if (!std::regex_match(line, match, symbolLine)) continue;
+
+		const std::string flags = match[2];
+		const uint32_t size = std::stoul(match[4], nullptr, 16);
+
+		if (size == 0 || (flags[6] != 'F' && flags[6] != 'O') || match[3] == "*ABS*" || match[3] == "*UND*")
+			continue;
+
+		const uint32_t addr = std::stoul(match[1], nullptr, 16);
+		res.push_back({addr, {Demangle(match[5]), "?", TEXT, size}});
+	}
+
+	return res;
+}
+
+static Image LoadImage(const std::string& name, const fs::path& mapPath, const fs::path& symPath)
+{
+	Image res;
+	res.name = name;
+
+	const std::vector<InputSection> sections = ParseMap(mapPath);
+
+	for (const InputSection& section : sections)
+	{
+		if (section.isInITCM)
+			res.itcmSize += section.size;
+		else
+		{
+			res.start = std::min(res.start, section.addr);
+			res.end = std::max(res.end, section.addr + section.size);
+		}
+
+		res.total[section.cls] += section.size;
+		res.files[section.file][section.cls] += section.size;
+	}
+
+	if (!fs::exists(symPath)) return res;
+
+	for (auto& [addr, symbol] : ParseSymbols(symPath))
+	{
+		const auto section = std::ranges::upper_bound(sections, addr, {}, &InputSection::addr);
+
+		if (section != sections.begin() && addr < section[-1].addr + section[-1].size)
+		{
+			symbol.cls = section[-1].cls;
+			symbol.file = section[-1].file;
+		}
+
+		res.symbols.push_back(symbol);
+	}
+
+	std::ranges::sort(res.symbols, std::greater{}, &Symbol::size);
+	return res;
+}
+
+static uint32_t Sum(const Sizes& sizes)
+{
+	return sizes[TEXT] + sizes[RODATA] + sizes[DATA] + sizes[BSS];
+}
+
+static void PrintSizesHeader(const char* first)
+{
+	std::printf("  %-40s %8s %8s %8s %8s %8s\n", first, "text", "rodata", "data", "bss", "total");
+}
+
+static void PrintSizes(const std::string& name, const Sizes& sizes)
+{
+	std::printf("  %-40s %8u %8u %8u %8u %8u\n", name.c_str(), sizes[TEXT], sizes[RODATA], sizes[DATA], sizes[BSS], Sum(sizes));
+}
+
+static void PrintImage(const Image& image, unsigned top)
+{
+	std::printf("\n== %s: 0x%08x - 0x%08x ==\n", image.name.c_str(), image.start, image.end);
+
+	std::vector<std::pair<std::string, Sizes>> files(image.files.begin(), image.files.end());
+	std::ranges::sort(files, std::greater{}, [](const auto& file) { return Sum(file.second); });
+
+	PrintSizesHeader("file");
+	for (const auto& [file, sizes] : files)
+		PrintSizes(file, sizes);
+
+	PrintSizes("(total)", image.total);
+
+	if (image.symbols.empty()) return;
+
+	std::printf("\n  %8s  %-6s  %-24s %s\n", "size", "class", "file", "symbol");
+
+	for (unsigned i = 0; i < image.symbols.size() && i < top; i++)
+	{
+		const Symbol& symbol = image.symbols[i];
+		std::printf("  %8u  %-6s  %-24s %s\n", symbol.size, classNames[symbol.cls], symbol.file.c_str(), symbol.name.c_str());
+	}
+
+	if (image.symbols.size() > top)
+		std::printf("  ... %zu more, see --top\n", image.symbols.size() - top);
+}
+
+struct Region
+{
+	std::string name;
+	uint32_t start;
+	uint32_t end;
+};
+
+struct Layout
+{
+	std::map<std::string, uint32_t> constants;
+	std::vector<Region> regions;
+};
+
+// The addresses are defined in memory_map.h, the regions in multiheap.cpp
+static Layout ParseMultiHeap(const fs::path& memoryMapPath, const fs::path& multiHeapPath)
+{
+	static const std::regex defineLine(R"(^#define\s+(\w+)\s+(0x[0-9a-fA-F]+)\s*$)");
+	static const std::regex regionLine(R"(^REGION\((\w+),\s*(\w+),\s*(\w+)\))");
+
+	Layout res;
+
+	for (const fs::path& path : {memoryMapPath, multiHeapPath})
+	{
+		for (const std::string& line : ReadLines(path))
+		{
+			std::smatch match;
+
+			if (std::regex_match(line, match, defineLine))
+				res.constants[match[1]] = std::stoul(match[2], nullptr, 16);
+			else if (std::regex_search(line, match, regionLine))
+				res.regions.push_back({match[1], res.constants.at(match[2]), res.constants.at(match[3])});
+		}
+	}
+
+	return res;
+}
+
+static void PrintLayout(const Layout& layout, const Image* mainCode)
+{
+	std::printf("\n== Regions of multiheap.cpp ==\n");
+
+	for (const Region& region : layout.regions)
+	{
+		const uint32_t size = region.end - region.start;
+		std::printf("  %-26s 0x%08x - 0x%08x %8u", region.name.c_str(), region.start, region.end, size);
+
+		if (region.name == "RAM_BEFORE_INSERTED_CODE")
+			std::printf("  minus the largest level overlay");
+
+		std::printf("\n");
+	}
+
+	if (!mainCode) return;
+
+	const auto itcmStart = layout.constants.find("ITCM_ARENA_START");
+	const auto itcmEnd = layout.constants.find("MAIN_RAM_START");
+
+	if (itcmStart != layout.constants.end() && itcmEnd != layout.constants.end())
+	{
+		const uint32_t size = itcmEnd->second - itcmStart->second;
+		std::printf("  %-26s 0x%08x - 0x%08x %8u  ITCM_CODE: %u, headroom %d\n", "ITCM", itcmStart->second, itcmEnd->second,
+			size, mainCode->itcmSize, static_cast<int>(size - mainCode->itcmSize));
+	}
+
+	const auto codeStart = layout.constants.find("INSERTED_CODE_START");
+	if (codeStart == layout.constants.end()) return;
+
+	if (mainCode->start != codeStart->second)
+		std::printf("  warning: newcode is linked at 0x%08x, but INSERTED_CODE_START is 0x%08x\n",
+			mainCode->start, codeStart->second);
+
+	// The next constant after the code is what it must not run into
+	const std::pair<const std::string, uint32_t>* limit = nullptr;
+	for (const auto& constant : layout.constants)
+		if (constant.second > codeStart->second && (!limit || constant.second < limit->second))
+			limit = &constant;
+
+	// The code for ITCM is stored after the rest until it's copied
+	const uint32_t codeEnd = mainCode->end + mainCode->itcmSize;
+	std::printf("  %-26s 0x%08x - 0x%08x %8u", "newcode", mainCode->start, codeEnd, codeEnd - mainCode->start);
+	if (limit)
+		std::printf("  headroom to %s: %d", limit->first.c_str(), static_cast<int>(limit->second - codeEnd));
+
+	std::printf("\n");
+}
+
+// The file --save writes has one line per file and symbol: IMAGE\tfile\tNAME\tTEXT\tRODATA\tDATA\tBSS
+// and IMAGE\tsym\tNAME\tSIZE. Symbols with the same name in one image are added up.
+using Snapshot = std::map<std::string, int64_t>;
+
+static Snapshot MakeSnapshot(const std::vector<Image>& images)
+{
+	Snapshot res;
+
+	for (const Image& image : images)
+	{
+		for (const auto& [file, sizes] : image.files)
+			for (unsigned cls = 0; cls < NUM_CLASSES; cls++)
+				res[image.name + "\tfile\t" + file + "\t" + classNames[cls]] += sizes[cls];
+
+		for (const Symbol& symbol : image.symbols)
+			res[image.name + "\tsym\t" + symbol.name] += symbol.size;
+	}
+
+	return res;
+}
+
+static void SaveSnapshot(const fs::path& path, const Snapshot& snapshot)
+{
+	std::ofstream file(path);
+	if (!file) Fail("can't write ", path.string());
+
+	for (const auto& [key, size] : snapshot)
+		file << key << '\t' << size << '\n';
+}
+
+static Snapshot LoadSnapshot(const fs::path& path)
+{
+	Snapshot res;
+
+	for (const std::string& line : ReadLines(path))
+	{
+		const size_t tab = line.rfind('\t');
+		if (tab == std::string::npos) Fail("malformed snapshot line: ", line);
+
+		res[line.substr(0, tab)] = std::stoll(line.substr(tab + 1));
+	}
+
+	return res;
+}
+
+static void PrintDiff(const Snapshot& before, const Snapshot& after, unsigned top)
+{
+	std::map<std::string, int64_t> deltas;
+
+	for (const auto& [key, size] : after) deltas[key] += size;
+	for (const auto& [key, size] : before) deltas[key] -= size;
+
+	std::vector<std::pair<std::string, int64_t>> files, symbols;
+	std::map<std::string, int64_t> imageTotals;
+
+	for (const auto& [key, delta] : deltas)
+	{
+		if (delta == 0) continue;
+
+		const size_t tab = key.find('\t');
+		const std::string image = key.substr(0, tab);
+
+		if (key.compare(tab + 1, 4, "file") == 0)
+		{
+			files.push_back({key, delta});
+			imageTotals[image] += delta;
+		}
+		else
+			symbols.push_back({key, delta});
+	}
+
+	const auto ByDelta = [](const auto& entry) { return -std::abs(entry.second); };
+	std::ranges::stable_sort(files, {}, ByDelta);
+	std::ranges::stable_sort(symbols, {}, ByDelta);
+
+	const auto Print = [&](const char* title, const std::vector<std::pair<std::string, int64_t>>& entries)
+	{
+		std::printf("\n== %s ==\n", title);
+
+		for (unsigned i = 0; i < entries.size() && i < top; i++)
+		{
+			std::string key = entries[i].first;
+			std::ranges::replace(key, '\t', ' ');
+			std::printf("  %+8lld  %s\n", static_cast<long long>(entries[i].second), key.c_str());
+		}
+
+		if (entries.empty()) std::printf("  no changes\n");
+	};
+
+	std::printf("\n== Changes by image ==\n");
+	for (const auto& [image, delta] : imageTotals)
+		std::printf("  %+8lld  %s\n", static_cast<long long>(delta), image.c_str());
+
+	if (imageTotals.empty()) std::printf("  no changes\n");
+
+	Print("Changes by file", files);
+	Print("Changes by symbol", symbols);
+}
+
+int main(int argc, char** argv)
+{
+	fs::path root = "../..";
+	const char* savePath = nullptr;
+	const char* diffPath = nullptr;
+	unsigned top = 20;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const auto NextArg = [&] { if (++i == argc) Fail("missing value for ", argv[i - 1]); return argv[i]; };
+
+		if (std::strcmp(argv[i], "--root") == 0) root = NextArg();
+		else if (std::strcmp(argv[i], "--save") == 0) savePath = NextArg();
+		else if (std::strcmp(argv[i], "--diff") == 0) diffPath = NextArg();
+		else if (std::strcmp(argv[i], "--top") == 0) top = std::stoul(NextArg());
+		else
+		{
+			std::fputs(
+				"usage: mem_budget [--root DIR] [--top N] [--save FILE] [--diff FILE]\n"
+				"  --root DIR   the repository with the build to analyze (default: ../..)\n"
+				"  --top N      the number of functions and changes to list (default: 20)\n"
+				"  --save FILE  write the sizes to FILE for a later --diff\n"
+				"  --diff FILE  compare the sizes to the ones saved in FILE\n",
+				stderr
+			);
+			return 1;
+		}
+	}
+
+	std::vector<Image> images;
+
+	if (fs::exists(root / "build/newcode.map"))
+		images.push_back(LoadImage("newcode", root / "build/newcode.map", root / "newcode.sym"));
+
+	std::vector<fs::path> dlDirs;
+	if (fs::exists(root / "dynamic_lib/build"))
+		for (const fs::directory_entry& entry : fs::directory_iterator(root / "dynamic_lib/build"))
+			if (fs::exists(entry.path() / "newcode.map"))
+				dlDirs.push_back(entry.path());
+
+	std::ranges::sort(dlDirs);
+	for (const fs::path& dir : dlDirs)
+		images.push_back(LoadImage("DL " + dir.filename().string(), dir / "newcode.map", dir / "newcode_lo.sym"));
+
+	if (images.empty()) Fail("no link maps found in ", root.string());
+
+	for (const Image& image : images)
+		PrintImage(image, top);
+
+	const bool hasMainCode = images[0].name == "newcode";
+
+	if (fs::exists(root / "source/multiheap.cpp") && fs::exists(root / "source/memory_map.h"))
+		PrintLayout(ParseMultiHeap(root / "source/memory_map.h", root / "source/multiheap.cpp"), hasMainCode ? &images[0] : nullptr);
+
+	const Snapshot snapshot = MakeSnapshot(images);
+
+	if (diffPath)
+		PrintDiff(LoadSnapshot(diffPath), snapshot, top);
+
+	if (savePath)
+		SaveSnapshot(savePath, snapshot);
+}